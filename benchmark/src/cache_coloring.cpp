@@ -0,0 +1,66 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <decodeless/allocator.hpp>
+#include <decodeless/allocator_construction.hpp>
+#include <decodeless/cache_coloring.hpp>
+#include <decodeless/virtual_memory_resource.hpp>
+#include <span>
+#include <vector>
+
+using namespace decodeless;
+
+static constexpr size_t streams = 8;
+static constexpr size_t elements = size_t(1) << 16;
+static constexpr int    repeats = 200;
+
+// Sums 'streams' arrays into 'out' in lockstep, returning the best time per
+// element in nanoseconds
+static double time_streams(std::span<std::span<float>> in, std::span<float> out) {
+    double best = 1e30;
+    for (int run = 0; run < 5; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; ++r) {
+            for (size_t i = 0; i < elements; ++i) {
+                float sum = out[i];
+                for (std::span<float> s : in)
+                    sum += s[i];
+                out[i] = sum;
+            }
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count() / double(elements * repeats));
+    }
+    return best;
+}
+
+template <class MemoryResource>
+static double run(MemoryResource& memory) {
+    std::vector<std::span<float>> in;
+    for (size_t s = 0; s < streams; ++s) {
+        in.push_back(create::array<float>(memory, elements));
+        std::ranges::fill(in.back(), float(s));
+    }
+    std::span<float> out = create::array<float>(memory, elements);
+    return time_streams(in, out);
+}
+
+int main() {
+    size_t reserve = (streams + 1) * (elements * sizeof(float) + 4096);
+
+    linear_memory_resource<virtual_memory_resource> plain(virtual_memory_resource{reserve});
+    double                                          plainTime = run(plain);
+
+    linear_memory_resource<virtual_memory_resource> backing(virtual_memory_resource{reserve});
+    cache_colored_resource                          colored(backing);
+    double                                          coloredTime = run(colored);
+
+    std::printf("%zu streams of %zu floats\n", streams, elements);
+    std::printf("back to back:  %.3f ns/element\n", plainTime);
+    std::printf("cache colored: %.3f ns/element\n", coloredTime);
+    return 0;
+}
@@ -0,0 +1,46 @@
+# Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+# decodeless_embed_arena(<target> <generator>
+#                        [NAME <name>] [ALIGNMENT <bytes>] [ARGS <args>...])
+#
+# Runs the executable target <generator> at build time as
+# "<generator> <image_path> [args...]" and embeds the arena image it writes
+# into the read-only data of <target>. The image is then available with zero
+# I/O via decodeless_embedded_arena_<name>(), declared by
+# DECODELESS_EMBEDDED_ARENA(<name>) from decodeless/embedded_arena.hpp. NAME
+# defaults to the generator target name and ALIGNMENT to 64 bytes.
+function(decodeless_embed_arena target generator)
+  cmake_parse_arguments(ARG "" "NAME;ALIGNMENT" "ARGS" ${ARGN})
+  if(NOT ARG_NAME)
+    set(ARG_NAME ${generator})
+  endif()
+  if(NOT ARG_ALIGNMENT)
+    set(ARG_ALIGNMENT 64)
+  endif()
+  string(MAKE_C_IDENTIFIER ${ARG_NAME} NAME)
+  set(ALIGNMENT ${ARG_ALIGNMENT})
+  set(IMAGE ${CMAKE_CURRENT_BINARY_DIR}/decodeless_arena_${NAME}.bin)
+  set(SOURCE ${CMAKE_CURRENT_BINARY_DIR}/decodeless_arena_${NAME}.cpp)
+
+  add_custom_command(
+    OUTPUT ${IMAGE}
+    COMMAND ${generator} ${IMAGE} ${ARG_ARGS}
+    DEPENDS ${generator}
+    COMMENT "Generating decodeless arena image ${NAME}")
+
+  if(MSVC)
+    # No .incbin; convert the image to an array initializer at build time
+    add_custom_command(
+      OUTPUT ${SOURCE}
+      COMMAND ${CMAKE_COMMAND} -DIMAGE=${IMAGE} -DSOURCE=${SOURCE} -DNAME=${NAME}
+              -DALIGNMENT=${ALIGNMENT} -P
+              ${CMAKE_CURRENT_FUNCTION_LIST_DIR}/decodeless_embed_arena_array.cmake
+      DEPENDS ${IMAGE} ${CMAKE_CURRENT_FUNCTION_LIST_DIR}/decodeless_embed_arena_array.cmake
+      COMMENT "Embedding decodeless arena image ${NAME}")
+  else()
+    configure_file(${CMAKE_CURRENT_FUNCTION_LIST_DIR}/decodeless_embed_arena.cpp.in ${SOURCE}
+                   @ONLY)
+    set_source_files_properties(${SOURCE} PROPERTIES OBJECT_DEPENDS ${IMAGE})
+  endif()
+  target_sources(${target} PRIVATE ${SOURCE} ${IMAGE})
+endfunction()
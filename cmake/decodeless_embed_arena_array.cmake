@@ -0,0 +1,24 @@
+# Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+# Script mode helper for decodeless_embed_arena() on compilers without .incbin.
+# Writes SOURCE defining the embedded arena accessor from the bytes of IMAGE.
+file(READ ${IMAGE} hex HEX)
+string(LENGTH "${hex}" hex_length)
+math(EXPR size "${hex_length} / 2")
+if(size EQUAL 0)
+  set(bytes "0")
+else()
+  string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${hex}")
+endif()
+file(WRITE ${SOURCE}
+  "// Generated by decodeless_embed_arena() from ${IMAGE}\n"
+  "\n"
+  "#include <cstddef>\n"
+  "#include <span>\n"
+  "\n"
+  "alignas(${ALIGNMENT}) static const unsigned char decodeless_arena_${NAME}[] = {${bytes}};\n"
+  "\n"
+  "// Matches DECODELESS_EMBEDDED_ARENA(${NAME})\n"
+  "std::span<const std::byte> decodeless_embedded_arena_${NAME}() {\n"
+  "    return {reinterpret_cast<const std::byte*>(decodeless_arena_${NAME}), ${size}};\n"
+  "}\n")
@@ -0,0 +1,64 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <decodeless/allocator_concepts.hpp>
+#include <decodeless/parallel.hpp>
+#include <span>
+#include <vector>
+
+namespace decodeless {
+
+// Makes one allocation for tasks of the given 'sizes', e.g. the outputs of a
+// parallel-for where each task knows its size up front, and returns a pointer
+// for each task. Offsets are computed with a parallel exclusive scan over
+// 'threads' chunks, zero for all hardware threads. Each task's output is
+// aligned to 'align', which must be a power of two. The layout only depends on
+// 'sizes', so images are reproducible regardless of thread timing and tasks
+// never contend on the resource.
+template <memory_resource MemoryResource>
+[[nodiscard]] std::vector<void*> allocate_parallel(MemoryResource& resource,
+                                                   std::span<const size_t> sizes, size_t align,
+                                                   size_t threads = 0) {
+    assert(align != 0 && (align & (align - 1)) == 0);
+    std::vector<void*> result(sizes.size());
+    if (sizes.empty())
+        return result;
+    auto padded = [align](size_t size) { return (size + align - 1) & ~(align - 1); };
+    if (threads == 0)
+        threads = default_thread_count();
+    threads = std::max(size_t(1), std::min(threads, sizes.size()));
+    auto chunkBegin = [&](size_t chunk) { return chunk * sizes.size() / threads; };
+
+    // Sum each chunk, then scan the chunk totals serially
+    std::vector<size_t> chunkOffsets(threads + 1, 0);
+    parallel_for_chunks(threads, threads, [&](size_t first, size_t last) {
+        for (size_t chunk = first; chunk < last; ++chunk) {
+            size_t total = 0;
+            for (size_t i = chunkBegin(chunk); i < chunkBegin(chunk + 1); ++i)
+                total += padded(sizes[i]);
+            chunkOffsets[chunk + 1] = total;
+        }
+    });
+    for (size_t chunk = 0; chunk < threads; ++chunk)
+        chunkOffsets[chunk + 1] += chunkOffsets[chunk];
+
+    auto* base = static_cast<std::byte*>(resource.allocate(chunkOffsets.back(), align));
+
+    // Scan within each chunk from its offset
+    parallel_for_chunks(threads, threads, [&](size_t first, size_t last) {
+        for (size_t chunk = first; chunk < last; ++chunk) {
+            size_t offset = chunkOffsets[chunk];
+            for (size_t i = chunkBegin(chunk); i < chunkBegin(chunk + 1); ++i) {
+                result[i] = base + offset;
+                offset += padded(sizes[i]);
+            }
+        }
+    });
+    return result;
+}
+
+} // namespace decodeless
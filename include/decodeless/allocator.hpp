@@ -2,13 +2,22 @@
 
 #pragma once
 
+#include <algorithm>
 #include <assert.h>
+#include <bit>
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
 #include <decodeless/allocator_concepts.hpp>
 #include <memory>
 
+// Keeps rarely taken slow paths out of inlined fast paths
+#if defined(_MSC_VER)
+    #define DECODELESS_COLD_NOINLINE __declspec(noinline)
+#else
+    #define DECODELESS_COLD_NOINLINE [[gnu::noinline, gnu::cold]]
+#endif
+
 namespace decodeless {
 
 // Utility for a linear_memory_resource backed by either a memory resource or an
@@ -54,6 +63,9 @@ class linear_memory_resource {
 public:
     using parent_allocator = ResOrAlloc;
 
+    // Growth either happens in place or throws, so allocations never move
+    static constexpr bool address_stable = true;
+
     // Non-reallocating parent allocator constructor must take an initial size
     linear_memory_resource(size_t initialSize, const ResOrAlloc& parent = ResOrAlloc())
         requires allocator<ResOrAlloc>
@@ -122,50 +134,30 @@ public:
         // Allocate
         uintptr_t newNext = result + bytes;
 
-        // Check for overflow and attempt to reallocate if possible
-        if (newNext > m_end) {
-            if constexpr (realloc_resource_or_allocator<ResOrAlloc>) {
-                // Allocate the larger of double the existing arena or enough to
-                // fit what was just requested.
-                size_t minSize = newNext - reinterpret_cast<uintptr_t>(m_begin);
-                size_t newSize = std::max(minSize, 2 * capacity());
-
-                // If double the reservation would overflow the backing
-                // allocator, allocate exactly the maximum.
-                if constexpr (has_max_size<ResOrAlloc>) {
-                    if (newSize > m_parent.max_size() && size() < m_parent.max_size()) {
-                        newSize = m_parent.max_size();
-                    }
-                }
-
-                if (capacity() == 0) {
-                    // Handle an empty initial allocation growing for the firs time
-                    m_begin = allocate_bytes(m_parent, newSize);
-                    newNext += reinterpret_cast<uintptr_t>(m_begin);
-                    result += reinterpret_cast<uintptr_t>(m_begin);
-                } else {
-                    // Verify the reallocation produced the same address.
-                    std::byte* addr = reallocate_bytes(m_parent, m_begin, newSize);
-                    if (addr != m_begin) {
-                        throw std::bad_alloc();
-                    }
-                }
-
-                m_end = reinterpret_cast<uintptr_t>(m_begin) + newSize;
-            } else {
-                // Double check there was an initial backing allocating from the
-                // non-reallocating parent and this is a real OOM
-                assert(capacity() != 0);
-                throw std::bad_alloc();
-            }
-        }
+        // Grow out of line so the fast path stays small enough to inline
+        if (newNext > m_end) [[unlikely]]
+            return allocate_grow(bytes, align);
 
-        // Safe to update m_next as no exceptions were thrown.
         m_next = newNext;
-
         return reinterpret_cast<void*>(result);
     }
 
+    // allocate() that bumps to the next multiple of 'boundary' only if the
+    // allocation would otherwise cross one, so a small hot object touches a
+    // single cache line or page. 'boundary' is a power of two no smaller than
+    // 'bytes' or 'align'.
+    [[nodiscard]] void* allocate_no_straddle(std::size_t bytes, std::size_t align,
+                                             std::size_t boundary = 64) {
+        assert(std::has_single_bit(boundary) && bytes <= boundary && align <= boundary);
+        uintptr_t result = m_next + ((-static_cast<ptrdiff_t>(m_next)) & (align - 1));
+
+        // The first allocation of an empty arena may move, so align it fully
+        if (capacity() == 0 ||
+            (bytes != 0 && ((result ^ (result + bytes - 1)) & ~uintptr_t(boundary - 1)) != 0))
+            align = boundary;
+        return allocate(bytes, align);
+    }
+
     // Deallocates memory. This operation is a no-op for linear_memory_resource
     // as individual deallocations are not supported.
     constexpr void deallocate(void* p, std::size_t bytes) {
@@ -178,6 +170,24 @@ public:
     // previously allocated memory.
     void reset() { m_next = reinterpret_cast<uintptr_t>(m_begin); }
 
+    // reset() that also decommits the pages of all previous allocations, e.g.
+    // to punch holes in a backing file so dead contents are never written back
+    // or to release the memory of an idle arena.
+    void reset_decommit()
+        requires has_decommit<ResOrAlloc>
+    {
+        if (size() != 0)
+            m_parent.decommit(m_begin, size());
+        reset();
+    }
+
+    // Frees all allocations made since size() returned 'marker', invalidating
+    // them. Markers must be rewound in LIFO order.
+    void rewind(size_t marker) {
+        assert(marker <= size());
+        m_next = reinterpret_cast<uintptr_t>(m_begin) + marker;
+    }
+
     // Reallocate the parent allocation to exactly the size of all current
     // allocations.
     void truncate()
@@ -209,9 +219,71 @@ public:
     [[nodiscard]] size_t capacity() const { return m_end - reinterpret_cast<uintptr_t>(m_begin); }
 
     // Provide public access to parent allocator. Primarily used for testing.
-    [[nodiscard]] ResOrAlloc& parent() { return m_parent; }
+    [[nodiscard]] ResOrAlloc&       parent() { return m_parent; }
+    [[nodiscard]] const ResOrAlloc& parent() const { return m_parent; }
 
 private:
+    // Slow path of allocate() when the arena is full. Grows the parent
+    // allocation if possible, otherwise throws std::bad_alloc.
+    DECODELESS_COLD_NOINLINE void* allocate_grow(std::size_t bytes, std::size_t align) {
+        if constexpr (growable_resource_or_allocator<ResOrAlloc>) {
+            for (;;) {
+                // Alignment is recomputed after growing as the first parent
+                // allocation defines the address
+                uintptr_t result = m_next + ((-static_cast<ptrdiff_t>(m_next)) & (align - 1));
+                uintptr_t newNext = result + bytes;
+                if (newNext <= m_end) {
+                    m_next = newNext;
+                    return reinterpret_cast<void*>(result);
+                }
+                grow(newNext - reinterpret_cast<uintptr_t>(m_begin));
+            }
+        } else {
+            // Double check there was an initial backing allocating from the
+            // non-reallocating parent and this is a real OOM
+            (void)bytes;
+            (void)align;
+            assert(capacity() != 0);
+            throw std::bad_alloc();
+        }
+    }
+
+    // Grows the parent allocation to at least 'minSize' bytes
+    void grow(size_t minSize)
+        requires growable_resource_or_allocator<ResOrAlloc>
+    {
+        // Allocate the larger of double the existing arena or enough to fit
+        // what was just requested.
+        size_t newSize = std::max(minSize, 2 * capacity());
+
+        // If double the reservation would overflow the backing allocator,
+        // allocate exactly the maximum.
+        if constexpr (has_max_size<ResOrAlloc>) {
+            if (minSize > m_parent.max_size())
+                throw std::bad_alloc();
+            newSize = std::min(newSize, size_t(m_parent.max_size()));
+        }
+
+        if (capacity() == 0) {
+            // Handle an empty initial allocation growing for the first time
+            size_t offset = m_next - reinterpret_cast<uintptr_t>(m_begin);
+            m_begin = allocate_bytes(m_parent, newSize);
+            m_next = reinterpret_cast<uintptr_t>(m_begin) + offset;
+        } else if constexpr (has_try_expand<ResOrAlloc>) {
+            // Preferred as a failed reallocate() may have already moved the
+            // allocation
+            if (!m_parent.try_expand(m_begin, newSize))
+                throw std::bad_alloc();
+        } else {
+            // Verify the reallocation produced the same address.
+            std::byte* addr = reallocate_bytes(m_parent, m_begin, newSize);
+            if (addr != m_begin) {
+                throw std::bad_alloc();
+            }
+        }
+        m_end = reinterpret_cast<uintptr_t>(m_begin) + newSize;
+    }
+
     void free() {
         if (capacity() != 0)
             m_parent.deallocate(m_begin, capacity());
@@ -231,6 +303,11 @@ public:
     using resource_type = MemoryResource;
     using value_type = T;
 
+    // Forward capabilities of the resource
+    static constexpr bool zero_filled = decodeless::zero_filled<MemoryResource>;
+    static constexpr bool address_stable = decodeless::address_stable<MemoryResource>;
+    static constexpr bool page_aligned = decodeless::page_aligned<MemoryResource>;
+
     memory_resource_ref(resource_type& resource)
         : m_resource(&resource) {}
 
@@ -3,6 +3,7 @@
 #pragma once
 
 #include <concepts>
+#include <cstddef>
 #include <type_traits>
 #include <utility>
 
@@ -79,6 +80,78 @@ concept has_max_size = memory_resource_or_allocator<ResOrAlloc> && requires(ResO
     { allocator.max_size() } -> std::same_as<std::size_t>;
 };
 
+// Parents that can write a sub-range of their allocation back to durable
+// storage, e.g. a file mapping calling msync() or FlushViewOfFile(). The call
+// must not return until the range is durable.
+template <class ResOrAlloc>
+concept has_flush = memory_resource_or_allocator<ResOrAlloc> && requires(ResOrAlloc& resOrAlloc) {
+    {
+        // flush(ptr, size)
+        resOrAlloc.flush(std::declval<std::byte*>(), std::declval<std::size_t>())
+    } -> std::same_as<void>;
+};
+
+// Parents that can release the physical pages of a sub-range of an allocation
+// while keeping it allocated and accessible. The range reads as zero when next
+// touched. Only whole pages within the range are affected.
+template <class ResOrAlloc>
+concept has_decommit =
+    memory_resource_or_allocator<ResOrAlloc> && requires(ResOrAlloc& resOrAlloc) {
+        {
+            // decommit(ptr, size)
+            resOrAlloc.decommit(std::declval<std::byte*>(), std::declval<std::size_t>())
+        } -> std::same_as<void>;
+    };
+
+// Parents that can grow an allocation in place. Unlike reallocate(), the
+// allocation is never moved and false is returned if it cannot grow.
+template <class ResOrAlloc>
+concept has_try_expand =
+    memory_resource_or_allocator<ResOrAlloc> && requires(ResOrAlloc& resOrAlloc) {
+        {
+            // try_expand(ptr, size)
+            resOrAlloc.try_expand(std::declval<std::byte*>(), std::declval<std::size_t>())
+        } -> std::same_as<bool>;
+    };
+
+// Parents a linear_memory_resource can grow, preferring try_expand()
+template <class ResOrAlloc>
+concept growable_resource_or_allocator =
+    realloc_resource_or_allocator<ResOrAlloc> || has_try_expand<ResOrAlloc>;
+
+// Resources that can place an allocation so it does not cross a multiple of a
+// boundary, e.g. a cache line or page, without over-aligning it
+template <class Resource>
+concept has_allocate_no_straddle =
+    memory_resource<Resource> && requires(Resource& resource) {
+        {
+            // allocate_no_straddle(bytes, align, boundary)
+            resource.allocate_no_straddle(std::declval<std::size_t>(),
+                                          std::declval<std::size_t>(),
+                                          std::declval<std::size_t>())
+        } -> std::same_as<void*>;
+    };
+
+// Opt-in capabilities, declared as static constexpr bool members of the same
+// name, e.g. 'static constexpr bool zero_filled = true;'. Wrappers can forward
+// them from their parent and consumers pick cheaper code paths at compile time.
+// A missing or false member means the capability is absent.
+
+// New memory, including memory added by growth, reads as zero
+template <class ResOrAlloc>
+concept zero_filled = memory_resource_or_allocator<ResOrAlloc> &&
+                      requires { requires bool(ResOrAlloc::zero_filled); };
+
+// Existing allocations never move, even when the parent grows
+template <class ResOrAlloc>
+concept address_stable = memory_resource_or_allocator<ResOrAlloc> &&
+                         requires { requires bool(ResOrAlloc::address_stable); };
+
+// Allocations start on a page boundary
+template <class ResOrAlloc>
+concept page_aligned = memory_resource_or_allocator<ResOrAlloc> &&
+                       requires { requires bool(ResOrAlloc::page_aligned); };
+
 template <typename T>
 concept trivially_destructible = std::is_trivially_destructible_v<T>;
 
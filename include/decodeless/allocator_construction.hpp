@@ -2,8 +2,12 @@
 
 #pragma once
 
+#include <algorithm>
+#include <bit>
+#include <decodeless/allocator_concepts.hpp>
 #include <memory>
 #include <span>
+#include <type_traits>
 
 #if __has_include(<ranges>)
     #include <ranges>
@@ -13,6 +17,14 @@ namespace decodeless {
 
 namespace create {
 
+// True if value initializing a T is equivalent to zero filling its bytes, so
+// construction can be skipped for zero_filled memory. Null pointers to data
+// members are not all zero bits on common ABIs.
+template <class T>
+inline constexpr bool zero_value_initialized =
+    std::is_trivially_default_constructible_v<T> && std::is_trivially_copyable_v<T> &&
+    !std::is_member_object_pointer_v<std::remove_all_extents_t<T>>;
+
 // Utility calls to construct objects from a decodeless memory resource
 namespace from_resource {
 
@@ -33,14 +45,34 @@ T* object(MemoryResource& memoryResource, Args&&... args) {
         std::forward<Args>(args)...);
 };
 
-// Default construct an array of 'size' objects.
+// Construct an object that does not straddle a 'Boundary' byte cache line or
+// page, which would double the lines a lookup touches. Uses
+// allocate_no_straddle() if available, otherwise over-aligns the object to the
+// next power of two of its size.
+template <trivially_destructible T, size_t Boundary = 64, memory_resource MemoryResource,
+          class... Args>
+T* object_compact(MemoryResource& memoryResource, Args&&... args) {
+    static_assert(!std::is_const_v<T>, "const construction not allowed. cast instead");
+    static_assert(sizeof(T) <= Boundary, "object is larger than the boundary");
+    void* ptr;
+    if constexpr (has_allocate_no_straddle<MemoryResource>)
+        ptr = memoryResource.allocate_no_straddle(sizeof(T), alignof(T), Boundary);
+    else
+        ptr = memoryResource.allocate(sizeof(T), std::max(alignof(T), std::bit_ceil(sizeof(T))));
+    return std::construct_at<T>(reinterpret_cast<T*>(ptr), std::forward<Args>(args)...);
+};
+
+// Default construct an array of 'size' objects. Skipped if the memory is
+// already zero and that is equivalent.
 template <trivially_destructible T, memory_resource MemoryResource>
 std::span<T> array(MemoryResource& memoryResource, size_t size) {
     static_assert(!std::is_const_v<T>, "const construction not allowed. cast instead");
     auto result = std::span(
         reinterpret_cast<T*>(memoryResource.allocate(sizeof(T) * size, alignof(T))), size);
-    for (auto& obj : result)
-        std::construct_at<T>(&obj);
+    if constexpr (!(zero_filled<MemoryResource> && zero_value_initialized<T>)) {
+        for (auto& obj : result)
+            std::construct_at<T>(&obj);
+    }
     return result;
 };
 
@@ -92,13 +124,16 @@ T* object(const Allocator& allocator, Args&&... args) {
                                 std::forward<Args>(args)...);
 };
 
-// Default construct an array of 'size' objects.
+// Default construct an array of 'size' objects. Skipped if the memory is
+// already zero and that is equivalent.
 template <trivially_destructible T, allocator Allocator>
 std::span<T> array(const Allocator& allocator, size_t size) {
     static_assert(!std::is_const_v<T>, "const construction not allowed. cast instead");
     auto result = std::span(allocator_rebind_t<T, Allocator>(allocator).allocate(size), size);
-    for (auto& obj : result)
-        std::construct_at<T>(&obj);
+    if constexpr (!(zero_filled<Allocator> && zero_value_initialized<T>)) {
+        for (auto& obj : result)
+            std::construct_at<T>(&obj);
+    }
     return result;
 };
 
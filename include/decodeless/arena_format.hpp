@@ -0,0 +1,67 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <cstddef>
+#include <decodeless/allocator.hpp>
+#include <iterator>
+#include <string_view>
+#include <utility>
+
+#if __has_include(<format>)
+    #include <format>
+#endif
+
+namespace decodeless {
+
+// Output iterator writing characters straight to the bump pointer of a
+// linear_memory_resource. Each character extends the arena's last allocation
+// in place, growing the arena as needed. The output is the range from the
+// arena's size() when the iterator was created to its current size(), so every
+// copy of the iterator sees the same result, e.g. with *it++ = c or from
+// std::format_to() or std::copy(). Anything else allocated from the arena in
+// the meantime becomes part of the output.
+template <class ResOrAlloc>
+class arena_output_iterator {
+public:
+    using iterator_category = std::output_iterator_tag;
+    using value_type = void;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = void;
+
+    explicit arena_output_iterator(linear_memory_resource<ResOrAlloc>& resource)
+        : m_resource(&resource)
+        , m_start(resource.size()) {}
+
+    arena_output_iterator& operator=(char c) {
+        *static_cast<char*>(m_resource->allocate(1, 1)) = c;
+        return *this;
+    }
+    arena_output_iterator& operator*() { return *this; }
+    arena_output_iterator& operator++() { return *this; }
+    arena_output_iterator  operator++(int) { return *this; }
+
+    // The characters written so far, in the arena
+    [[nodiscard]] std::string_view view() const {
+        return {static_cast<const char*>(m_resource->data()) + m_start,
+                m_resource->size() - m_start};
+    }
+
+private:
+    linear_memory_resource<ResOrAlloc>* m_resource;
+    size_t                              m_start;
+};
+
+#ifdef __cpp_lib_format
+// Formats directly into the arena, avoiding a temporary std::string and a copy.
+// The result is not null terminated.
+template <class ResOrAlloc, class... Args>
+std::string_view arena_format_to(linear_memory_resource<ResOrAlloc>& resource,
+                                 std::format_string<Args...> fmt, Args&&... args) {
+    return std::format_to(arena_output_iterator(resource), fmt, std::forward<Args>(args)...)
+        .view();
+}
+#endif
+
+} // namespace decodeless
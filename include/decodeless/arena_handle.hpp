@@ -0,0 +1,107 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+
+namespace decodeless {
+
+namespace detail {
+
+// Returns (p - base) >> Shift as 32 bits, throwing if p is before base,
+// misaligned for the scale or too far away
+template <unsigned Shift>
+uint32_t arena_offset32(const void* base, const void* p) {
+    uintptr_t from = reinterpret_cast<uintptr_t>(base);
+    uintptr_t to = reinterpret_cast<uintptr_t>(p);
+    if (to < from)
+        throw std::overflow_error("arena handle target precedes the arena");
+    uint64_t offset = static_cast<uint64_t>(to - from);
+    if (offset & ((uint64_t(1) << Shift) - 1))
+        throw std::overflow_error("arena handle target is not aligned to its scale");
+    if ((offset >> Shift) >= std::numeric_limits<uint32_t>::max())
+        throw std::overflow_error("arena handle offset does not fit in 32 bits");
+    return static_cast<uint32_t>(offset >> Shift);
+}
+
+} // namespace detail
+
+// A 32-bit reference to a T in an arena, stored as an offset from the arena's
+// data() rather than a 64-bit pointer. The offset is scaled by 2^Shift, so a
+// Shift of 2-4 reaches 16-64 GiB arenas when targets are aligned to match.
+// Resolving needs the arena base, which also makes handles valid in images
+// mapped at any address. The all-ones offset is reserved for null.
+template <class T, unsigned Shift = 0>
+class arena_handle {
+public:
+    static_assert(Shift < 32);
+    static constexpr uint32_t null_offset = std::numeric_limits<uint32_t>::max();
+
+    arena_handle() = default;
+
+    // Creates a handle to 'p' in the arena at 'base', e.g. the result of
+    // create::object(). Null maps to null. Throws std::overflow_error if the
+    // offset cannot be represented.
+    arena_handle(const void* base, const T* p)
+        : m_offset(p ? detail::arena_offset32<Shift>(base, p) : null_offset) {}
+
+    [[nodiscard]] T* get(void* base) const {
+        return m_offset == null_offset ? nullptr
+                                       : reinterpret_cast<T*>(static_cast<std::byte*>(base) +
+                                                              (uint64_t(m_offset) << Shift));
+    }
+    [[nodiscard]] const T* get(const void* base) const {
+        return get(const_cast<void*>(base));
+    }
+
+    // Byte offset from the arena base
+    [[nodiscard]] uint64_t offset() const { return uint64_t(m_offset) << Shift; }
+    [[nodiscard]] uint32_t raw() const { return m_offset; }
+
+    explicit operator bool() const { return m_offset != null_offset; }
+    bool     operator==(const arena_handle& other) const = default;
+
+private:
+    uint32_t m_offset = null_offset;
+};
+
+// A 32-bit offset and 32-bit size referencing an array in an arena, e.g. the
+// result of create::array(). Half the size of a std::span.
+template <class T, unsigned Shift = 0>
+class arena_span32 {
+public:
+    static_assert(Shift < 32);
+
+    arena_span32() = default;
+
+    // Throws std::overflow_error if the offset or size cannot be represented
+    arena_span32(const void* base, std::span<T> span)
+        : m_offset(span.empty() ? 0 : detail::arena_offset32<Shift>(base, span.data()))
+        , m_size(static_cast<uint32_t>(span.size())) {
+        if (span.size() > std::numeric_limits<uint32_t>::max())
+            throw std::overflow_error("arena span size does not fit in 32 bits");
+    }
+
+    [[nodiscard]] std::span<T> get(void* base) const {
+        return {reinterpret_cast<T*>(static_cast<std::byte*>(base) + offset()), m_size};
+    }
+    [[nodiscard]] std::span<const T> get(const void* base) const {
+        return get(const_cast<void*>(base));
+    }
+
+    [[nodiscard]] uint64_t offset() const { return uint64_t(m_offset) << Shift; }
+    [[nodiscard]] size_t   size() const { return m_size; }
+    [[nodiscard]] bool     empty() const { return m_size == 0; }
+
+    bool operator==(const arena_span32& other) const = default;
+
+private:
+    uint32_t m_offset = 0;
+    uint32_t m_size = 0;
+};
+
+} // namespace decodeless
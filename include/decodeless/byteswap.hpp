@@ -0,0 +1,182 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// SSSE3 is enabled per function with a runtime check on GCC/Clang, rather than
+// requiring the whole program to be compiled with -mssse3
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    #include <immintrin.h>
+    #define DECODELESS_BYTESWAP_SSSE3 1
+    #define DECODELESS_BYTESWAP_SSSE3_TARGET __attribute__((target("ssse3")))
+    #define DECODELESS_BYTESWAP_SSSE3_SUPPORTED __builtin_cpu_supports("ssse3")
+#elif defined(_M_X64) && defined(__AVX__)
+    #include <immintrin.h>
+    #define DECODELESS_BYTESWAP_SSSE3 1
+    #define DECODELESS_BYTESWAP_SSSE3_TARGET
+    #define DECODELESS_BYTESWAP_SSSE3_SUPPORTED true
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    #include <arm_neon.h>
+    #define DECODELESS_BYTESWAP_NEON 1
+#endif
+
+namespace decodeless {
+
+// Data layout traits of the machine that wrote an image. Stored in image
+// headers so readers can detect foreign images. Images that differ only in
+// byte order can be converted with byteswap_records(), which is a single
+// bandwidth-bound pass, instead of decoding every field on access.
+struct image_abi {
+    uint8_t bigEndian;
+    uint8_t pointerSize;
+    uint8_t longSize;
+    uint8_t longDoubleSize;
+    uint8_t maxAlign;
+    uint8_t reserved[3];
+
+    static constexpr image_abi host() {
+        return {std::endian::native == std::endian::big,
+                sizeof(void*),
+                sizeof(long),
+                sizeof(long double),
+                alignof(std::max_align_t),
+                {}};
+    }
+
+    // True if only the byte order differs from 'other'
+    [[nodiscard]] constexpr bool byteswap_compatible(const image_abi& other) const {
+        return pointerSize == other.pointerSize && longSize == other.longSize &&
+               longDoubleSize == other.longDoubleSize && maxAlign == other.maxAlign;
+    }
+
+    bool operator==(const image_abi& other) const = default;
+};
+
+// Describes a multi-byte scalar, or an array of 'count' of them, within a
+// record that should be byte swapped. E.g. {offsetof(T, m), sizeof(T::m)}.
+struct field_descriptor {
+    size_t offset;
+    size_t size;
+    size_t count = 1;
+};
+
+namespace detail {
+
+// Builds the byte permutation that swaps each described field of a record.
+// Bytes not covered by a field are left in place. Throws std::invalid_argument
+// for a zero stride or fields outside the record.
+inline std::vector<size_t> byteswap_permutation(size_t stride,
+                                                std::span<const field_descriptor> fields) {
+    if (stride == 0)
+        throw std::invalid_argument("byteswap record stride must not be zero");
+    std::vector<size_t> permutation(stride);
+    for (size_t i = 0; i < stride; ++i)
+        permutation[i] = i;
+    for (const field_descriptor& field : fields) {
+        if (field.size == 0 || field.offset > stride ||
+            field.count > (stride - field.offset) / field.size)
+            throw std::invalid_argument("byteswap field outside the record");
+        for (size_t element = 0; element < field.count; ++element) {
+            size_t begin = field.offset + element * field.size;
+            for (size_t i = 0; i < field.size; ++i)
+                permutation[begin + i] = begin + field.size - 1 - i;
+        }
+    }
+    return permutation;
+}
+
+// Applies a 16 byte shuffle to as many whole 16 byte blocks as possible and
+// returns the number of bytes processed
+#if defined(DECODELESS_BYTESWAP_SSSE3)
+DECODELESS_BYTESWAP_SSSE3_TARGET inline size_t
+shuffle_blocks(const std::byte* src, std::byte* dst, size_t bytes, const uint8_t (&mask)[16]) {
+    __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask));
+    size_t  i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(v, m));
+    }
+    return i;
+}
+#elif defined(DECODELESS_BYTESWAP_NEON)
+inline size_t
+shuffle_blocks(const std::byte* src, std::byte* dst, size_t bytes, const uint8_t (&mask)[16]) {
+    uint8x16_t m = vld1q_u8(mask);
+    size_t     i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(src + i));
+        vst1q_u8(reinterpret_cast<uint8_t*>(dst + i), vqtbl1q_u8(v, m));
+    }
+    return i;
+}
+#endif
+
+inline bool simd_shuffle_supported() {
+#if defined(DECODELESS_BYTESWAP_SSSE3)
+    static const bool supported = DECODELESS_BYTESWAP_SSSE3_SUPPORTED;
+    return supported;
+#elif defined(DECODELESS_BYTESWAP_NEON)
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace detail
+
+// Byte swaps the described fields of 'count' records of 'stride' bytes from
+// 'src' to 'dst', which may be the same for in-place conversion. Throws
+// std::invalid_argument for a zero stride or fields outside the record. Records whose
+// stride divides 16 bytes are converted 16 bytes at a time with a single
+// pshufb/tbl shuffle where available.
+inline void byteswap_records(const void* src, void* dst, size_t count, size_t stride,
+                             std::span<const field_descriptor> fields) {
+    std::vector<size_t> permutation = detail::byteswap_permutation(stride, fields);
+    const std::byte*    in = static_cast<const std::byte*>(src);
+    std::byte*          out = static_cast<std::byte*>(dst);
+    size_t              bytes = count * stride;
+    size_t              done = 0;
+#if defined(DECODELESS_BYTESWAP_SSSE3) || defined(DECODELESS_BYTESWAP_NEON)
+    if (16 % stride == 0 && detail::simd_shuffle_supported()) {
+        uint8_t mask[16];
+        for (size_t i = 0; i < 16; ++i)
+            mask[i] = static_cast<uint8_t>(i / stride * stride + permutation[i % stride]);
+        done = detail::shuffle_blocks(in, out, bytes, mask);
+    }
+#endif
+
+    // Copied first as 'src' and 'dst' may alias
+    std::vector<std::byte> record(stride);
+    for (size_t offset = done; offset < bytes; offset += stride) {
+        std::memcpy(record.data(), in + offset, stride);
+        for (size_t i = 0; i < stride; ++i)
+            out[offset + i] = record[permutation[i]];
+    }
+}
+
+// In-place overload of byteswap_records()
+inline void byteswap_records(void* data, size_t count, size_t stride,
+                             std::span<const field_descriptor> fields) {
+    byteswap_records(data, data, count, stride, fields);
+}
+
+// Byte swaps every element of an array of scalars in place, e.g. after loading
+// an image with a foreign image_abi::bigEndian.
+template <class T>
+    requires std::is_trivially_copyable_v<T>
+void byteswap_inplace(std::span<T> values) {
+    static_assert(sizeof(T) <= 16, "byteswap_inplace() expects scalar elements");
+    field_descriptor field{0, sizeof(T)};
+    byteswap_records(values.data(), values.size(), sizeof(T), std::span(&field, 1));
+}
+
+} // namespace decodeless
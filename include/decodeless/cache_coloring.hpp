@@ -0,0 +1,83 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <decodeless/allocator_concepts.hpp>
+
+namespace decodeless {
+
+struct cache_coloring {
+    // Allocations of at least this many bytes are colored
+    size_t threshold = 16384;
+
+    // Distance between colors. A multiple of the cache line size keeps line
+    // alignment.
+    size_t step = 256;
+
+    // Number of colors. Large allocation k starts at (k % colors) * step modulo
+    // colors * step. With the defaults that is a 4 KiB period, so up to 16
+    // streams land in different L1 sets and never 4K-alias each other.
+    size_t colors = 16;
+};
+
+// Decorates a linear resource to start consecutive large allocations at
+// rotating offsets modulo colors * step (cache coloring). Back to back power of
+// two sized arrays otherwise start at addresses that map to the same cache
+// sets, so kernels streaming several of them in lockstep see conflict misses.
+// The next address is read from the resource's data() and size() and padding
+// up to the target color is taken as a separate allocation that is never
+// deallocated, at most colors * step bytes each time. Colors are only exact if
+// a large allocation's alignment divides 'step'.
+template <memory_resource MemoryResource>
+    requires requires(const MemoryResource& resource) {
+        resource.data();
+        resource.size();
+    }
+class cache_colored_resource {
+public:
+    // Capabilities, see allocator_concepts.hpp
+    static constexpr bool zero_filled = decodeless::zero_filled<MemoryResource>;
+    static constexpr bool address_stable = decodeless::address_stable<MemoryResource>;
+
+    explicit cache_colored_resource(MemoryResource& resource, const cache_coloring& options = {})
+        : m_resource(&resource)
+        , m_options(options) {
+        assert(m_options.colors != 0 && m_options.step != 0);
+    }
+
+    [[nodiscard]] void* allocate(std::size_t bytes, std::size_t align) {
+        if (bytes >= m_options.threshold) {
+            size_t period = m_options.colors * m_options.step;
+            size_t target = (m_largeCount++ % m_options.colors) * m_options.step;
+            for (;;) {
+                void*     base = m_resource->data();
+                uintptr_t next = reinterpret_cast<uintptr_t>(base) + m_resource->size();
+                uintptr_t aligned = next + ((-static_cast<ptrdiff_t>(next)) & (align - 1));
+                size_t    pad = (aligned - next) + (target + period - aligned % period) % period;
+                if (pad == 0)
+                    break;
+                (void)m_resource->allocate(pad, 1);
+
+                // Padding the first allocation of an empty arena may move it
+                if (m_resource->data() == base)
+                    break;
+            }
+        }
+        return m_resource->allocate(bytes, align);
+    }
+
+    void deallocate(void* p, std::size_t bytes) { m_resource->deallocate(p, bytes); }
+
+    [[nodiscard]] MemoryResource&       resource() const { return *m_resource; }
+    [[nodiscard]] const cache_coloring& options() const { return m_options; }
+
+private:
+    MemoryResource* m_resource;
+    cache_coloring  m_options;
+    size_t          m_largeCount = 0;
+};
+
+} // namespace decodeless
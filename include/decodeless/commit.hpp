@@ -0,0 +1,68 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <decodeless/allocator.hpp>
+#include <decodeless/allocator_concepts.hpp>
+#include <stdexcept>
+
+namespace decodeless {
+
+// Crash-consistent append-only arenas. A commit_header is the first object in
+// the arena and records how many bytes have been durably written. commit()
+// flushes only the bytes appended since the previous commit, then atomically
+// publishes the new size. After a crash, anything past the committed size may
+// be torn and is discarded by recover().
+struct commit_header {
+    alignas(std::atomic_ref<uint64_t>::required_alignment) uint64_t committedSize = 0;
+};
+
+// Creates the commit header as the first allocation of an empty arena.
+template <memory_resource_or_allocator ResOrAlloc>
+commit_header* create_commit_header(linear_memory_resource<ResOrAlloc>& memory) {
+    assert(memory.size() == 0);
+    return std::construct_at(reinterpret_cast<commit_header*>(
+        memory.allocate(sizeof(commit_header), alignof(commit_header))));
+}
+
+// Durably commits all allocations made since the last commit. The new range is
+// flushed before the committed size is updated and the header is flushed last,
+// so a reader never sees a committed size covering unflushed data.
+template <has_flush ResOrAlloc>
+void commit(linear_memory_resource<ResOrAlloc>& memory, commit_header& header) {
+    std::atomic_ref<uint64_t> committed(header.committedSize);
+    size_t                    begin = static_cast<size_t>(committed.load(std::memory_order_acquire));
+    size_t                    end = memory.size();
+    assert(begin <= end);
+    if (begin == end)
+        return;
+    std::byte* base = static_cast<std::byte*>(memory.data());
+    memory.parent().flush(base + begin, end - begin);
+    committed.store(end, std::memory_order_release);
+    memory.parent().flush(reinterpret_cast<std::byte*>(&header), sizeof(header));
+}
+
+// Reopens an arena whose backing allocation holds a previously committed
+// image, e.g. a re-mapped file. The arena must be empty. Allocation resumes at
+// the last committed size; uncommitted bytes are overwritten by new
+// allocations. A zero committed size is treated as a fresh arena.
+template <memory_resource_or_allocator ResOrAlloc>
+commit_header* recover(linear_memory_resource<ResOrAlloc>& memory) {
+    assert(memory.size() == 0);
+    if (memory.capacity() < sizeof(commit_header))
+        return create_commit_header(memory);
+    auto*    header = reinterpret_cast<commit_header*>(memory.data());
+    uint64_t committed =
+        std::atomic_ref<uint64_t>(header->committedSize).load(std::memory_order_acquire);
+    if (committed == 0)
+        return create_commit_header(memory);
+    if (committed < sizeof(commit_header) || committed > memory.capacity())
+        throw std::runtime_error("corrupt commit header");
+    (void)memory.allocate(static_cast<size_t>(committed), 1);
+    return header;
+}
+
+} // namespace decodeless
@@ -0,0 +1,118 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <decodeless/allocator_concepts.hpp>
+#include <decodeless/allocator_construction.hpp>
+#include <decodeless/parallel.hpp>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+
+namespace decodeless {
+
+// Compressed sparse row adjacency of a directed graph, as created by
+// create::csr_graph(). The neighbors of vertex v are
+// neighbors[offsets[v]] to neighbors[offsets[v + 1]], sorted ascending.
+template <std::unsigned_integral Index>
+struct csr_graph_view {
+    std::span<Index> offsets;
+    std::span<Index> neighbors;
+
+    [[nodiscard]] size_t vertex_count() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    [[nodiscard]] size_t edge_count() const { return neighbors.size(); }
+
+    [[nodiscard]] std::span<const Index> adjacent(size_t vertex) const {
+        assert(vertex < vertex_count());
+        return std::span<const Index>(neighbors).subspan(
+            offsets[vertex], offsets[vertex + 1] - offsets[vertex]);
+    }
+};
+
+namespace create {
+
+namespace from_resource {
+
+// Builds a CSR graph directly in 'memoryResource' from an unsorted range of
+// (source, destination) edges. A parallel counting pass computes per-vertex
+// degrees in the offsets array, then a parallel scatter writes neighbors using
+// the offsets themselves as atomic cursors, so nothing but the final offsets
+// and neighbors arrays is ever allocated. Neighbor lists are sorted afterwards
+// so the result does not depend on thread timing. Pass zero threads to use all
+// hardware threads. Throws std::length_error if the edge count or vertex ids do
+// not fit in Index and std::out_of_range if an edge references a vertex id of
+// 'vertexCount' or more, both before anything is allocated.
+template <std::unsigned_integral Index, std::ranges::random_access_range Edges,
+          memory_resource MemoryResource>
+    requires std::ranges::sized_range<Edges>
+csr_graph_view<Index> csr_graph(MemoryResource& memoryResource, size_t vertexCount, Edges&& edges,
+                                size_t threads = 0) {
+    size_t edgeCount = std::ranges::size(edges);
+    auto   first = std::ranges::begin(edges);
+    if (edgeCount > std::numeric_limits<Index>::max() ||
+        (vertexCount != 0 && vertexCount - 1 > std::numeric_limits<Index>::max()))
+        throw std::length_error("csr_graph edge or vertex count exceeds the Index type");
+
+    // Validate vertex ids up front. Scatter indexes offsets by them unchecked.
+    std::atomic<bool> outOfRange = false;
+    parallel_for_chunks(edgeCount, threads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const auto& [source, destination] = first[i];
+            if (static_cast<size_t>(source) >= vertexCount ||
+                static_cast<size_t>(destination) >= vertexCount) {
+                outOfRange.store(true, std::memory_order_relaxed);
+                return;
+            }
+        }
+    });
+    if (outOfRange)
+        throw std::out_of_range("csr_graph edge references a vertex id out of range");
+
+    std::span<Index> offsets = array<Index>(memoryResource, vertexCount + 1);
+    std::span<Index> neighbors = array<Index>(memoryResource, edgeCount);
+
+    // Count out-degrees, shifted by one so the scan gives start offsets
+    parallel_for_chunks(edgeCount, threads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const auto& [source, destination] = first[i];
+            std::atomic_ref<Index>(offsets[static_cast<size_t>(source) + 1])
+                .fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    for (size_t v = 1; v <= vertexCount; ++v)
+        offsets[v] += offsets[v - 1];
+
+    // Scatter, bumping each vertex's start offset to its end offset
+    parallel_for_chunks(edgeCount, threads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const auto& [source, destination] = first[i];
+            Index slot = std::atomic_ref<Index>(offsets[static_cast<size_t>(source)])
+                             .fetch_add(1, std::memory_order_relaxed);
+            neighbors[slot] = static_cast<Index>(destination);
+        }
+    });
+
+    // Each offsets[v] now holds the original offsets[v + 1]. Shift them back.
+    for (size_t v = vertexCount; v > 0; --v)
+        offsets[v] = offsets[v - 1];
+    offsets[0] = 0;
+
+    // Scatter order depends on thread timing. Sort for a reproducible image.
+    parallel_for_chunks(vertexCount, threads, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v)
+            std::sort(neighbors.begin() + offsets[v], neighbors.begin() + offsets[v + 1]);
+    });
+    return {offsets, neighbors};
+}
+
+} // namespace from_resource
+
+} // namespace create
+
+} // namespace decodeless
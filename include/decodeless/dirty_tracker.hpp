@@ -0,0 +1,180 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <decodeless/allocator.hpp>
+#include <decodeless/page_size.hpp>
+#include <vector>
+
+#if defined(__linux__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+namespace decodeless {
+
+// A byte range relative to the start of a tracked region
+struct page_range {
+    size_t offset;
+    size_t size;
+    bool   operator==(const page_range& other) const = default;
+};
+
+// Tracks which pages of a region have been written since the last clear(), so
+// incremental snapshots and replication only need to ship changed pages.
+// - soft_dirty: Linux soft-dirty bits, read from /proc/self/pagemap and reset
+//   by writing to /proc/self/clear_refs. Catches every write with no code
+//   changes, but clearing is process-wide and resets all other soft-dirty
+//   trackers too.
+// - software: Writers must call mark_dirty(). Always available.
+// mark_dirty() is honoured in both modes, e.g. for writes made by a device or
+// another process the kernel would not attribute to this mapping.
+class dirty_tracker {
+public:
+    enum class mode { soft_dirty, software };
+
+    dirty_tracker(void* data, size_t size, mode trackingMode = best_mode())
+        : m_begin(align_down(reinterpret_cast<uintptr_t>(data), page_size()))
+        , m_offset(reinterpret_cast<uintptr_t>(data) - m_begin)
+        , m_size(size)
+        , m_mode(trackingMode)
+        , m_marked((m_offset + size + page_size() - 1) / page_size(), false) {
+        assert(m_mode != mode::soft_dirty || soft_dirty_supported());
+        clear();
+    }
+
+    // Tracks the whole arena allocation. Note that the region is fixed at
+    // construction and is not updated if the arena is later reallocated.
+    template <memory_resource_or_allocator ResOrAlloc>
+    dirty_tracker(const linear_memory_resource<ResOrAlloc>& memory,
+                  mode                                      trackingMode = best_mode())
+        : dirty_tracker(memory.data(), memory.capacity(), trackingMode) {}
+
+    // Software write barrier. Records a write to [p, p + bytes).
+    void mark_dirty(const void* p, size_t bytes) {
+        if (bytes == 0)
+            return;
+        uintptr_t addr = reinterpret_cast<uintptr_t>(p);
+        assert(addr >= m_begin + m_offset && addr + bytes <= m_begin + m_offset + m_size);
+        size_t first = (addr - m_begin) / page_size();
+        size_t last = (addr + bytes - 1 - m_begin) / page_size();
+        for (size_t page = first; page <= last; ++page)
+            m_marked[page] = true;
+    }
+
+    // Returns coalesced ranges of pages written since the last clear(), clipped
+    // to the tracked region.
+    [[nodiscard]] std::vector<page_range> enumerate_dirty() const {
+        std::vector<bool> dirty = m_marked;
+#if defined(__linux__)
+        if (m_mode == mode::soft_dirty)
+            read_soft_dirty(dirty);
+#endif
+        std::vector<page_range> result;
+        for (size_t page = 0; page < dirty.size(); ++page) {
+            if (!dirty[page])
+                continue;
+            size_t begin = std::max(page * page_size(), m_offset);
+            size_t end = std::min((page + 1) * page_size(), m_offset + m_size);
+            if (!result.empty() && result.back().offset + result.back().size == begin - m_offset)
+                result.back().size += end - begin;
+            else
+                result.push_back({begin - m_offset, end - begin});
+        }
+        return result;
+    }
+
+    // Starts a new tracking interval
+    void clear() {
+        std::fill(m_marked.begin(), m_marked.end(), false);
+#if defined(__linux__)
+        if (m_mode == mode::soft_dirty)
+            clear_soft_dirty();
+#endif
+    }
+
+    [[nodiscard]] mode tracking_mode() const { return m_mode; }
+
+    // Returns true if the kernel maintains soft-dirty bits. Probing clears the
+    // process' soft-dirty bits once.
+    static bool soft_dirty_supported() {
+#if defined(__linux__)
+        static const bool supported = probe_soft_dirty();
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    static mode best_mode() {
+        return soft_dirty_supported() ? mode::soft_dirty : mode::software;
+    }
+
+private:
+#if defined(__linux__)
+    static constexpr uint64_t pagemap_soft_dirty_bit = uint64_t(1) << 55;
+
+    static bool clear_soft_dirty() {
+        int fd = open("/proc/self/clear_refs", O_WRONLY | O_CLOEXEC);
+        if (fd == -1)
+            return false;
+        bool ok = write(fd, "4", 1) == 1;
+        close(fd);
+        return ok;
+    }
+
+    static bool read_pagemap(uintptr_t begin, std::vector<uint64_t>& entries) {
+        int fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+            return false;
+        size_t  bytes = entries.size() * sizeof(uint64_t);
+        ssize_t bytesRead = pread(fd, entries.data(), bytes,
+                                  static_cast<off_t>(begin / page_size() * sizeof(uint64_t)));
+        close(fd);
+        return bytesRead == static_cast<ssize_t>(bytes);
+    }
+
+    void read_soft_dirty(std::vector<bool>& dirty) const {
+        std::vector<uint64_t> entries(dirty.size());
+        if (!read_pagemap(m_begin, entries)) {
+            // Conservatively report everything as changed
+            std::fill(dirty.begin(), dirty.end(), true);
+            return;
+        }
+        for (size_t page = 0; page < entries.size(); ++page)
+            if (entries[page] & pagemap_soft_dirty_bit)
+                dirty[page] = true;
+    }
+
+    // Writes to a scratch page and verifies the soft-dirty bit follows
+    static bool probe_soft_dirty() {
+        void* page =
+            mmap(nullptr, page_size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (page == MAP_FAILED)
+            return false;
+        volatile char*        byte = static_cast<volatile char*>(page);
+        std::vector<uint64_t> entry(1);
+        *byte = 1;
+        bool supported = clear_soft_dirty() &&
+                         read_pagemap(reinterpret_cast<uintptr_t>(page), entry) &&
+                         (entry[0] & pagemap_soft_dirty_bit) == 0;
+        *byte = 2;
+        supported = supported && read_pagemap(reinterpret_cast<uintptr_t>(page), entry) &&
+                    (entry[0] & pagemap_soft_dirty_bit) != 0;
+        munmap(page, page_size());
+        return supported;
+    }
+#endif
+
+    uintptr_t         m_begin;
+    size_t            m_offset;
+    size_t            m_size;
+    mode              m_mode;
+    std::vector<bool> m_marked;
+};
+
+} // namespace decodeless
@@ -0,0 +1,228 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <decodeless/allocator.hpp>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace decodeless {
+
+// A linear arena allocating from both ends of one parent allocation. The front
+// holds persistent output and grows up like a linear_memory_resource. The back
+// holds scratch allocations, grows down and is freed all at once with
+// reset_back(), so an encoder needs a single backing allocation rather than an
+// extra scratch arena. When the two meet, the parent allocation is grown in
+// place as for linear_memory_resource and the back region is moved to the new
+// end. Front allocations never move, but growth invalidates pointers to back
+// allocations. Reserve enough capacity up front if that matters.
+template <memory_resource_or_allocator ResOrAlloc = std::allocator<std::byte>>
+    requires memory_resource<ResOrAlloc> ||
+             std::same_as<typename ResOrAlloc::value_type, std::byte>
+class double_ended_linear_resource {
+public:
+    using parent_allocator = ResOrAlloc;
+
+    // Allocates from the back of a double_ended_linear_resource, e.g. for
+    // create::array(memory.back(), ...)
+    class back_resource {
+    public:
+        explicit back_resource(double_ended_linear_resource& memory)
+            : m_memory(&memory) {}
+        [[nodiscard]] void* allocate(std::size_t bytes, std::size_t align) {
+            return m_memory->allocate_back(bytes, align);
+        }
+        constexpr void deallocate(void* p, std::size_t bytes) {
+            (void)p;
+            (void)bytes;
+        }
+
+    private:
+        double_ended_linear_resource* m_memory;
+    };
+
+    double_ended_linear_resource(size_t initialSize, const ResOrAlloc& parent = ResOrAlloc())
+        requires allocator<ResOrAlloc>
+        : m_parent(parent) {
+        init(initialSize);
+    }
+
+    double_ended_linear_resource(size_t initialSize, ResOrAlloc&& parent)
+        requires memory_resource<ResOrAlloc>
+        : m_parent(std::move(parent)) {
+        init(initialSize);
+    }
+
+    double_ended_linear_resource(const double_ended_linear_resource& other) = delete;
+    double_ended_linear_resource(double_ended_linear_resource&& other) noexcept
+        : m_parent(std::move(other.m_parent))
+        , m_begin(std::exchange(other.m_begin, nullptr))
+        , m_front(std::exchange(other.m_front, 0))
+        , m_back(std::exchange(other.m_back, 0))
+        , m_backTop(std::exchange(other.m_backTop, 0))
+        , m_end(std::exchange(other.m_end, 0))
+        , m_backAlign(std::exchange(other.m_backAlign, 1)) {}
+    ~double_ended_linear_resource() { free(); }
+    double_ended_linear_resource& operator=(const double_ended_linear_resource& other) = delete;
+    double_ended_linear_resource& operator=(double_ended_linear_resource&& other) noexcept {
+        free();
+        m_parent = std::move(other.m_parent);
+        m_begin = std::exchange(other.m_begin, nullptr);
+        m_front = std::exchange(other.m_front, 0);
+        m_back = std::exchange(other.m_back, 0);
+        m_backTop = std::exchange(other.m_backTop, 0);
+        m_end = std::exchange(other.m_end, 0);
+        m_backAlign = std::exchange(other.m_backAlign, 1);
+        return *this;
+    }
+
+    // Allocates persistent memory from the front
+    [[nodiscard]] void* allocate(std::size_t bytes, std::size_t align) {
+        for (;;) {
+            uintptr_t result = m_front + ((-static_cast<ptrdiff_t>(m_front)) & (align - 1));
+            uintptr_t newFront = result + bytes;
+            if (newFront <= m_back) [[likely]] {
+                m_front = newFront;
+                return reinterpret_cast<void*>(result);
+            }
+            grow(capacity() + (newFront - m_back));
+        }
+    }
+
+    // Allocates scratch memory from the back. It is invalidated by
+    // reset_back(), truncate() and any growth.
+    [[nodiscard]] void* allocate_back(std::size_t bytes, std::size_t align) {
+        for (;;) {
+            if (m_back - m_front >= bytes) {
+                uintptr_t result = (m_back - bytes) & ~uintptr_t(align - 1);
+                if (result >= m_front) [[likely]] {
+                    m_back = result;
+                    m_backAlign = std::max(m_backAlign, align);
+                    return reinterpret_cast<void*>(result);
+                }
+            }
+            grow(capacity() + bytes + align);
+        }
+    }
+
+    // No-op, as for linear_memory_resource
+    constexpr void deallocate(void* p, std::size_t bytes) {
+        (void)p;
+        (void)bytes;
+    }
+
+    [[nodiscard]] back_resource back() { return back_resource(*this); }
+
+    // Frees all back allocations
+    void reset_back() {
+        m_back = m_end;
+        m_backTop = m_end;
+        m_backAlign = 1;
+    }
+
+    // Frees all allocations from both ends
+    void reset() {
+        m_front = reinterpret_cast<uintptr_t>(m_begin);
+        reset_back();
+    }
+
+    // Discards the back region and shrinks the parent allocation to exactly
+    // the front allocations
+    void truncate()
+        requires realloc_resource_or_allocator<ResOrAlloc>
+    {
+        reset_back();
+        if (size() == 0) {
+            free();
+            m_begin = nullptr;
+            m_front = m_back = m_backTop = m_end = 0;
+        } else {
+            std::byte* addr = reallocate_bytes(m_parent, m_begin, size());
+            if (addr != m_begin)
+                throw std::bad_alloc();
+            m_back = m_backTop = m_end = m_front;
+        }
+    }
+
+    [[nodiscard]] void* data() const { return m_begin; }
+
+    // Bytes allocated from the front
+    [[nodiscard]] size_t size() const { return m_front - reinterpret_cast<uintptr_t>(m_begin); }
+
+    // Bytes allocated from the back
+    [[nodiscard]] size_t back_size() const { return m_backTop - m_back; }
+
+    [[nodiscard]] size_t capacity() const { return m_end - reinterpret_cast<uintptr_t>(m_begin); }
+
+    [[nodiscard]] ResOrAlloc&       parent() { return m_parent; }
+    [[nodiscard]] const ResOrAlloc& parent() const { return m_parent; }
+
+private:
+    void init(size_t initialSize) {
+        if (initialSize != 0)
+            m_begin = allocate_bytes(m_parent, initialSize);
+        m_front = reinterpret_cast<uintptr_t>(m_begin);
+        m_end = m_front + initialSize;
+        reset_back();
+    }
+
+    // Grows the parent allocation in place to at least 'minSize' bytes and
+    // moves the back region to the new end
+    DECODELESS_COLD_NOINLINE void grow(size_t minSize) {
+        if constexpr (growable_resource_or_allocator<ResOrAlloc>) {
+            size_t newSize = std::max(minSize, 2 * capacity());
+            if constexpr (has_max_size<ResOrAlloc>) {
+                if (minSize > m_parent.max_size())
+                    throw std::bad_alloc();
+                newSize = std::min(newSize, size_t(m_parent.max_size()));
+            }
+            if (capacity() == 0) {
+                m_begin = allocate_bytes(m_parent, newSize);
+                m_front = m_back = m_backTop = m_end = reinterpret_cast<uintptr_t>(m_begin);
+            } else if constexpr (has_try_expand<ResOrAlloc>) {
+                if (!m_parent.try_expand(m_begin, newSize))
+                    throw std::bad_alloc();
+            } else {
+                if (reallocate_bytes(m_parent, m_begin, newSize) != m_begin)
+                    throw std::bad_alloc();
+            }
+            uintptr_t newEnd = reinterpret_cast<uintptr_t>(m_begin) + newSize;
+
+            // Move by a multiple of the largest back alignment to keep
+            // allocations aligned
+            uintptr_t shift = (newEnd - m_end) & ~uintptr_t(m_backAlign - 1);
+            if (back_size() != 0)
+                std::memmove(reinterpret_cast<void*>(m_back + shift),
+                             reinterpret_cast<void*>(m_back), back_size());
+            m_back += shift;
+            m_backTop += shift;
+            m_end = newEnd;
+            if (m_backTop == m_back)
+                m_back = m_backTop = m_end;
+        } else {
+            (void)minSize;
+            throw std::bad_alloc();
+        }
+    }
+
+    void free() {
+        if (capacity() != 0)
+            m_parent.deallocate(m_begin, capacity());
+    }
+
+    ResOrAlloc m_parent;
+    std::byte* m_begin = nullptr;
+    uintptr_t  m_front = 0;
+    uintptr_t  m_back = 0;
+    uintptr_t  m_backTop = 0;
+    uintptr_t  m_end = 0;
+    size_t     m_backAlign = 1;
+};
+
+} // namespace decodeless
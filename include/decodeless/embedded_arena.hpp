@@ -0,0 +1,119 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <decodeless/allocator.hpp>
+#include <decodeless/byteswap.hpp>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <span>
+#include <stdexcept>
+
+// Declares the accessor for an arena image embedded into the binary by the
+// decodeless_embed_arena() cmake function, e.g.
+//   DECODELESS_EMBEDDED_ARENA(tables);
+//   auto image = decodeless_embedded_arena_tables();
+#define DECODELESS_EMBEDDED_ARENA(name)                                                            \
+    std::span<const std::byte> decodeless_embedded_arena_##name()
+
+namespace decodeless {
+
+// Header written in front of an arena image by write_arena_image(). It is 64
+// bytes so the payload keeps the image's alignment, up to 64 bytes.
+struct arena_image_header {
+    static constexpr char magic_value[8] = {'D', 'L', 'I', 'M', 'A', 'G', 'E', '1'};
+    char                  magic[8];
+    image_abi             abi;
+    uint64_t              size;
+    uint8_t               reserved[40];
+};
+static_assert(sizeof(arena_image_header) == 64);
+
+// Writes the allocated bytes of an arena as an image with an
+// arena_image_header, e.g. from a build time generator for
+// decodeless_embed_arena(). The image is loaded at an unknown address so it
+// must not contain raw pointers.
+template <memory_resource_or_allocator ResOrAlloc>
+void write_arena_image(const linear_memory_resource<ResOrAlloc>& memory,
+                       const std::filesystem::path&              path) {
+    arena_image_header header{};
+    std::memcpy(header.magic, arena_image_header::magic_value, sizeof(header.magic));
+    header.abi = image_abi::host();
+    header.size = memory.size();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(static_cast<const char*>(memory.data()),
+               static_cast<std::streamsize>(memory.size()));
+    if (!file)
+        throw std::runtime_error("failed to write " + path.string());
+}
+
+// Returns the header of an image written by write_arena_image(), with 'size'
+// in host byte order. Throws std::runtime_error if 'image' is not an arena
+// image or is truncated.
+inline arena_image_header read_arena_image_header(std::span<const std::byte> image) {
+    arena_image_header header;
+    if (image.size() < sizeof(header))
+        throw std::runtime_error("truncated arena image");
+    std::memcpy(&header, image.data(), sizeof(header));
+    if (std::memcmp(header.magic, arena_image_header::magic_value, sizeof(header.magic)))
+        throw std::runtime_error("not an arena image");
+    if (header.abi.bigEndian != image_abi::host().bigEndian)
+        byteswap_inplace(std::span(&header.size, 1));
+    if (header.size > image.size() - sizeof(header))
+        throw std::runtime_error("truncated arena image");
+    return header;
+}
+
+// Returns the payload of a native arena image in place, e.g. of an embedded
+// one. Throws std::runtime_error if the image was written with a different
+// image_abi. Use load_arena_image() to convert foreign images.
+inline std::span<const std::byte> arena_image_data(std::span<const std::byte> image) {
+    arena_image_header header = read_arena_image_header(image);
+    if (header.abi != image_abi::host())
+        throw std::runtime_error("arena image ABI mismatch");
+    return image.subspan(sizeof(header), static_cast<size_t>(header.size));
+}
+
+// Copies the payload of an arena image into 'memory', aligned to 64 bytes, and
+// returns it. If the image differs from the host only in byte order, see
+// image_abi::byteswap_compatible(), swap(payload) is called on the copy to
+// convert it, e.g. with byteswap_records() for each array in the image. Any
+// other ABI mismatch throws std::runtime_error.
+template <memory_resource_or_allocator ResOrAlloc, class Swap>
+    requires std::invocable<Swap&, std::span<std::byte>>
+std::span<std::byte> load_arena_image(linear_memory_resource<ResOrAlloc>& memory,
+                                      std::span<const std::byte> image, Swap&& swap) {
+    arena_image_header header = read_arena_image_header(image);
+    image_abi          host = image_abi::host();
+    if (!host.byteswap_compatible(header.abi))
+        throw std::runtime_error("arena image ABI mismatch");
+    size_t               size = static_cast<size_t>(header.size);
+    std::span<std::byte> payload(static_cast<std::byte*>(memory.allocate(size, 64)), size);
+    if (size != 0)
+        std::memcpy(payload.data(), image.data() + sizeof(header), size);
+    if (header.abi.bigEndian != host.bigEndian)
+        swap(payload);
+    return payload;
+}
+
+// Returns the object of type T at 'offset' bytes into the payload of an
+// embedded or otherwise read-only native arena image, see arena_image_data().
+// The first object created in the generator's arena is at offset zero. The
+// image must be at least as aligned as T, which decodeless_embed_arena()
+// guarantees up to its ALIGNMENT.
+template <class T>
+const T& embedded_object(std::span<const std::byte> image, size_t offset = 0) {
+    std::span<const std::byte> data = arena_image_data(image);
+    assert(offset + sizeof(T) <= data.size());
+    assert(reinterpret_cast<uintptr_t>(data.data() + offset) % alignof(T) == 0);
+    return *std::launder(reinterpret_cast<const T*>(data.data() + offset));
+}
+
+} // namespace decodeless
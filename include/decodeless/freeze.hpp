@@ -0,0 +1,242 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <decodeless/allocator.hpp>
+#include <decodeless/allocator_concepts.hpp>
+#include <decodeless/page_size.hpp>
+#include <span>
+#include <stdexcept>
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <signal.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+    #if __has_include(<execinfo.h>)
+        #include <execinfo.h>
+        #define DECODELESS_FREEZE_BACKTRACE 1
+    #endif
+#endif
+
+namespace decodeless {
+
+struct freeze_options {
+    // Let the kernel merge identical pages (Linux KSM, best effort)
+    bool mergeable = false;
+
+    // Report the address and a backtrace of the writer when a frozen page is
+    // written before crashing, rather than a bare segmentation fault
+    bool trapWrites = false;
+};
+
+namespace detail {
+
+// Frozen ranges with write trapping, read lock-free from the fault handler
+struct frozen_registry {
+    static constexpr size_t capacity = 64;
+    std::atomic<uintptr_t>  begin[capacity];
+    std::atomic<uintptr_t>  end[capacity];
+
+    void add(uintptr_t first, uintptr_t last) {
+        for (size_t i = 0; i < capacity; ++i) {
+            uintptr_t expected = 0;
+            if (end[i].compare_exchange_strong(expected, last)) {
+                begin[i].store(first);
+                return;
+            }
+        }
+        // Writes to this range will still fault, just without a report
+    }
+
+    void remove(uintptr_t first) {
+        for (size_t i = 0; i < capacity; ++i) {
+            if (end[i].load() && begin[i].load() == first) {
+                begin[i].store(0);
+                end[i].store(0);
+            }
+        }
+    }
+
+    // Returns the frozen range base containing 'addr' or zero
+    uintptr_t find(uintptr_t addr) const {
+        for (size_t i = 0; i < capacity; ++i) {
+            uintptr_t first = begin[i].load();
+            if (first && addr >= first && addr < end[i].load())
+                return first;
+        }
+        return 0;
+    }
+};
+
+inline frozen_registry& frozen_ranges() {
+    static frozen_registry registry{};
+    return registry;
+}
+
+// Formats without allocating or locking, as it runs in a fault handler
+inline size_t format_frozen_write(char (&message)[128], uintptr_t addr, uintptr_t base) {
+    size_t length = 0;
+    auto   append = [&](const char* text) {
+        while (*text && length < sizeof(message))
+            message[length++] = *text++;
+    };
+    auto appendHex = [&](uintptr_t value) {
+        append("0x");
+        for (int shift = int(sizeof(value) * 8) - 4; shift >= 0; shift -= 4)
+            if (length < sizeof(message))
+                message[length++] = "0123456789abcdef"[(value >> shift) & 0xf];
+    };
+    append("decodeless: write to frozen arena at ");
+    appendHex(addr);
+    append(", offset ");
+    appendHex(addr - base);
+    append("\n");
+    return length;
+}
+
+#if defined(_WIN32)
+inline LONG WINAPI frozen_write_handler(EXCEPTION_POINTERS* exception) {
+    const EXCEPTION_RECORD* record = exception->ExceptionRecord;
+    if (record->ExceptionCode == EXCEPTION_ACCESS_VIOLATION && record->NumberParameters >= 2 &&
+        record->ExceptionInformation[0] == 1) {
+        uintptr_t addr = static_cast<uintptr_t>(record->ExceptionInformation[1]);
+        if (uintptr_t base = frozen_ranges().find(addr)) {
+            char   message[128];
+            size_t length = format_frozen_write(message, addr, base);
+            DWORD  written;
+            WriteFile(GetStdHandle(STD_ERROR_HANDLE), message, static_cast<DWORD>(length),
+                      &written, nullptr);
+        }
+    }
+    return EXCEPTION_CONTINUE_SEARCH;
+}
+
+inline void install_frozen_write_handler() {
+    static const bool installed =
+        AddVectoredExceptionHandler(1, frozen_write_handler) != nullptr;
+    (void)installed;
+}
+#else
+inline struct sigaction& previous_fault_action(int signal) {
+    static struct sigaction segv{};
+    static struct sigaction bus{};
+    return signal == SIGSEGV ? segv : bus;
+}
+
+inline void frozen_write_handler(int signal, siginfo_t* info, void* context) {
+    uintptr_t addr = reinterpret_cast<uintptr_t>(info->si_addr);
+    if (uintptr_t base = frozen_ranges().find(addr)) {
+        char   message[128];
+        size_t length = format_frozen_write(message, addr, base);
+        (void)!write(STDERR_FILENO, message, length);
+    #if defined(DECODELESS_FREEZE_BACKTRACE)
+        void* frames[64];
+        backtrace_symbols_fd(frames, backtrace(frames, 64), STDERR_FILENO);
+    #endif
+    } else {
+        const struct sigaction& previous = previous_fault_action(signal);
+        if ((previous.sa_flags & SA_SIGINFO) && previous.sa_sigaction) {
+            previous.sa_sigaction(signal, info, context);
+            return;
+        }
+        if (previous.sa_handler != SIG_DFL && previous.sa_handler != SIG_IGN) {
+            previous.sa_handler(signal);
+            return;
+        }
+    }
+
+    // Returning retries the write, which now crashes at the writer
+    ::signal(signal, SIG_DFL);
+}
+
+inline void install_frozen_write_handler() {
+    static const bool installed = [] {
+    #if defined(DECODELESS_FREEZE_BACKTRACE)
+        // The first call may load libgcc, which is unsafe in the handler
+        void* frame;
+        (void)backtrace(&frame, 1);
+    #endif
+        struct sigaction action {};
+        action.sa_sigaction = frozen_write_handler;
+        action.sa_flags = SA_SIGINFO;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGSEGV, &action, &previous_fault_action(SIGSEGV));
+        sigaction(SIGBUS, &action, &previous_fault_action(SIGBUS));
+        return true;
+    }();
+    (void)installed;
+}
+#endif
+
+inline void protect(std::span<const std::byte> pages, bool writable) {
+#if defined(_WIN32)
+    DWORD previous;
+    if (!VirtualProtect(const_cast<std::byte*>(pages.data()), pages.size(),
+                        writable ? PAGE_READWRITE : PAGE_READONLY, &previous))
+        throw std::runtime_error("VirtualProtect() failed");
+#else
+    if (mprotect(const_cast<std::byte*>(pages.data()), pages.size(),
+                 writable ? PROT_READ | PROT_WRITE : PROT_READ) != 0)
+        throw std::runtime_error("mprotect() failed");
+#endif
+}
+
+// Returns the whole pages covering 'range', which must start on a page
+inline std::span<const std::byte> covering_pages(std::span<const std::byte> range) {
+    assert(reinterpret_cast<uintptr_t>(range.data()) % page_size() == 0);
+    return {range.data(), align_up(range.size(), page_size())};
+}
+
+} // namespace detail
+
+// Makes the pages covering 'range' read-only, e.g. before forking workers that
+// only read it. A stray write then crashes immediately instead of silently
+// copying the page in each process. 'range' must start on a page boundary. The
+// rest of its last page is protected too.
+inline void freeze(std::span<const std::byte> range, const freeze_options& options = {}) {
+    if (range.empty())
+        return;
+    std::span<const std::byte> pages = detail::covering_pages(range);
+    if (options.trapWrites) {
+        detail::install_frozen_write_handler();
+        detail::frozen_ranges().add(reinterpret_cast<uintptr_t>(pages.data()),
+                                    reinterpret_cast<uintptr_t>(pages.data()) + pages.size());
+    }
+    detail::protect(pages, false);
+#if defined(MADV_MERGEABLE)
+    if (options.mergeable)
+        madvise(const_cast<std::byte*>(pages.data()), pages.size(), MADV_MERGEABLE);
+#endif
+}
+
+// Makes a range frozen with freeze() writable again
+inline void thaw(std::span<const std::byte> range) {
+    if (range.empty())
+        return;
+    std::span<const std::byte> pages = detail::covering_pages(range);
+    detail::protect(pages, true);
+    detail::frozen_ranges().remove(reinterpret_cast<uintptr_t>(pages.data()));
+}
+
+// Freezes all allocations of an arena with a page aligned parent. No further
+// allocations may be made until thaw().
+template <page_aligned Parent>
+void freeze(const linear_memory_resource<Parent>& memory, const freeze_options& options = {}) {
+    freeze(std::span(static_cast<const std::byte*>(memory.data()), memory.size()), options);
+}
+
+template <page_aligned Parent>
+void thaw(const linear_memory_resource<Parent>& memory) {
+    thaw(std::span(static_cast<const std::byte*>(memory.data()), memory.size()));
+}
+
+} // namespace decodeless
@@ -0,0 +1,80 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <decodeless/allocator.hpp>
+#include <decodeless/page_size.hpp>
+#include <decodeless/virtual_memory_resource.hpp>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace decodeless {
+
+// A linear_memory_resource with a separate large object space. Allocations of
+// at least 'threshold' bytes get their own dedicated mapping instead of growing
+// the arena, which would otherwise reallocate it to double its capacity or more
+// and keep that capacity for good. Large objects are released together on
+// reset() or destruction and are not part of the arena's contiguous image, so
+// size() only counts the arena and large_size() counts them separately.
+template <memory_resource_or_allocator ResOrAlloc = std::allocator<std::byte>>
+class large_object_linear_resource {
+public:
+    using arena_type = linear_memory_resource<ResOrAlloc>;
+
+    // Capabilities, see allocator_concepts.hpp
+    static constexpr bool address_stable = true;
+
+    large_object_linear_resource(arena_type&& arena, size_t threshold)
+        : m_arena(std::move(arena))
+        , m_threshold(threshold) {}
+
+    [[nodiscard]] void* allocate(std::size_t bytes, std::size_t align) {
+        if (bytes < m_threshold) [[likely]]
+            return m_arena.allocate(bytes, align);
+        return allocate_large(bytes, align);
+    }
+
+    // Individual deallocation is not supported, as for linear_memory_resource
+    constexpr void deallocate(void* p, std::size_t bytes) {
+        (void)p;
+        (void)bytes;
+    }
+
+    // Resets the arena and releases all large objects
+    void reset() {
+        m_arena.reset();
+        m_large.clear();
+        m_largeSize = 0;
+    }
+
+    // Bytes allocated from the arena, excluding large objects
+    [[nodiscard]] size_t size() const { return m_arena.size(); }
+
+    // Bytes allocated as large objects
+    [[nodiscard]] size_t large_size() const { return m_largeSize; }
+    [[nodiscard]] size_t large_count() const { return m_large.size(); }
+
+    [[nodiscard]] size_t threshold() const { return m_threshold; }
+
+    [[nodiscard]] arena_type&       arena() { return m_arena; }
+    [[nodiscard]] const arena_type& arena() const { return m_arena; }
+
+private:
+    DECODELESS_COLD_NOINLINE void* allocate_large(std::size_t bytes, std::size_t align) {
+        assert(align <= page_size());
+        virtual_memory_resource& mapping = m_large.emplace_back(bytes);
+        void*                    result = mapping.allocate(bytes, align);
+        m_largeSize += bytes;
+        return result;
+    }
+
+    arena_type                           m_arena;
+    std::vector<virtual_memory_resource> m_large;
+    size_t                               m_largeSize = 0;
+    size_t                               m_threshold;
+};
+
+} // namespace decodeless
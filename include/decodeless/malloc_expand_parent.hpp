@@ -0,0 +1,169 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// The heap is chosen at build time. CMake defines these when
+// DECODELESS_FIND_MALLOC_EXPAND is enabled and the library is found.
+#if defined(DECODELESS_MALLOC_EXPAND_MIMALLOC)
+    #include <mimalloc.h>
+#elif defined(DECODELESS_MALLOC_EXPAND_JEMALLOC)
+    #include <jemalloc/jemalloc.h>
+#elif defined(_WIN32)
+    #include <malloc.h>
+#else
+    #include <decodeless/page_size.hpp>
+    #if defined(__linux__)
+        #include <malloc.h>
+        #include <sys/mman.h>
+    #elif defined(__APPLE__)
+        #include <malloc/malloc.h>
+    #endif
+#endif
+
+namespace decodeless {
+
+// A heap parent for a growable linear_memory_resource that only ever grows
+// allocations in place. reallocate() returns the same pointer on success and
+// nullptr otherwise, which matches linear_memory_resource's address check, so
+// heap backed arenas can grow without reserving virtual address space. The
+// in-place expansion uses, in order of preference:
+// - mimalloc mi_expand()
+// - jemalloc xallocx()
+// - MSVC CRT _expand()
+// - Linux mremap() without MREMAP_MAYMOVE for chunks of at least
+//   mremap_threshold, which are mapped directly. Smaller chunks come from
+//   malloc() and can only grow within their usable size, so arenas that need
+//   to grow far should start at the threshold.
+class malloc_expand_parent {
+public:
+    // Capabilities, see allocator_concepts.hpp
+    static constexpr bool address_stable = true;
+
+    static constexpr size_t mremap_threshold = 128 * 1024;
+
+    [[nodiscard]] void* allocate(std::size_t bytes, std::size_t align) {
+        assert(align <= alignof(std::max_align_t));
+        (void)align;
+#if defined(DECODELESS_MALLOC_EXPAND_MIMALLOC)
+        void* result = mi_malloc(bytes);
+#elif defined(DECODELESS_MALLOC_EXPAND_JEMALLOC)
+        void* result = mallocx(bytes ? bytes : 1, 0);
+#elif defined(_WIN32)
+        void* result = std::malloc(bytes);
+#else
+        void* result = allocate_chunk(bytes);
+#endif
+        if (!result)
+            throw std::bad_alloc();
+        return result;
+    }
+
+    // Resizes in place, returning nullptr rather than moving the allocation
+    [[nodiscard]] void* reallocate(void* ptr, std::size_t bytes, std::size_t align) {
+        assert(align <= alignof(std::max_align_t));
+        (void)align;
+        return try_expand(ptr, bytes) ? ptr : nullptr;
+    }
+
+    // Resizes in place, returning false if the heap cannot resize there
+    [[nodiscard]] bool try_expand(void* ptr, std::size_t bytes) {
+#if defined(DECODELESS_MALLOC_EXPAND_MIMALLOC)
+        return mi_expand(ptr, bytes) != nullptr;
+#elif defined(DECODELESS_MALLOC_EXPAND_JEMALLOC)
+        return xallocx(ptr, bytes ? bytes : 1, 0, 0) >= bytes;
+#elif defined(_WIN32)
+        return _expand(ptr, bytes) != nullptr;
+#else
+        return resize_chunk(ptr, bytes);
+#endif
+    }
+
+    void deallocate(void* ptr, std::size_t bytes) {
+        (void)bytes;
+#if defined(DECODELESS_MALLOC_EXPAND_MIMALLOC)
+        mi_free(ptr);
+#elif defined(DECODELESS_MALLOC_EXPAND_JEMALLOC)
+        dallocx(ptr, 0);
+#elif defined(_WIN32)
+        std::free(ptr);
+#else
+        free_chunk(ptr);
+#endif
+    }
+
+#if !defined(DECODELESS_MALLOC_EXPAND_MIMALLOC) &&                                               \
+    !defined(DECODELESS_MALLOC_EXPAND_JEMALLOC) && !defined(_WIN32)
+private:
+    // Precedes each chunk to record how it was allocated. 'mapped' is the
+    // mapping size including the header or zero for malloc() chunks.
+    struct alignas(std::max_align_t) chunk_header {
+        size_t mapped;
+    };
+
+    static chunk_header* header(void* ptr) { return static_cast<chunk_header*>(ptr) - 1; }
+
+    static void* allocate_chunk(size_t bytes) {
+        chunk_header* chunk = nullptr;
+    #if defined(__linux__)
+        if (bytes >= mremap_threshold) {
+            size_t mapped = align_up(sizeof(chunk_header) + bytes, page_size());
+            void*  p = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                            -1, 0);
+            if (p == MAP_FAILED)
+                return nullptr;
+            chunk = static_cast<chunk_header*>(p);
+            chunk->mapped = mapped;
+            return chunk + 1;
+        }
+    #endif
+        chunk = static_cast<chunk_header*>(std::malloc(sizeof(chunk_header) + bytes));
+        if (!chunk)
+            return nullptr;
+        chunk->mapped = 0;
+        return chunk + 1;
+    }
+
+    static bool resize_chunk(void* ptr, size_t bytes) {
+        chunk_header* chunk = header(ptr);
+    #if defined(__linux__)
+        if (chunk->mapped) {
+            size_t mapped = align_up(sizeof(chunk_header) + bytes, page_size());
+            if (mapped != chunk->mapped) {
+                // Without MREMAP_MAYMOVE this only succeeds in place
+                if (mremap(chunk, chunk->mapped, mapped, 0) == MAP_FAILED)
+                    return false;
+                chunk->mapped = mapped;
+            }
+            return true;
+        }
+        return sizeof(chunk_header) + bytes <= malloc_usable_size(chunk);
+    #elif defined(__APPLE__)
+        return sizeof(chunk_header) + bytes <= malloc_size(chunk);
+    #else
+        // No way to query or grow a malloc() chunk in place
+        (void)chunk;
+        (void)bytes;
+        return false;
+    #endif
+    }
+
+    static void free_chunk(void* ptr) {
+        chunk_header* chunk = header(ptr);
+    #if defined(__linux__)
+        if (chunk->mapped) {
+            munmap(chunk, chunk->mapped);
+            return;
+        }
+    #endif
+        std::free(chunk);
+    }
+#endif
+};
+
+} // namespace decodeless
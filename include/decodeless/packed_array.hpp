@@ -0,0 +1,278 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <decodeless/allocator_concepts.hpp>
+#include <decodeless/allocator_construction.hpp>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+    #include <emmintrin.h>
+    #define DECODELESS_PACKED_ARRAY_SSE2 1
+#endif
+
+namespace decodeless {
+
+namespace detail {
+
+// Returns the first word and bit shift of value 'i' in the two lane interleaved
+// layout of packed_array_view
+inline std::pair<size_t, unsigned> packed_position(size_t i, unsigned bits) {
+    constexpr size_t blockSize = 128;
+    size_t           block = i / blockSize;
+    size_t           inBlock = i % blockSize;
+    size_t           bitOffset = (inBlock / 2) * bits;
+    size_t           word = block * blockSize * bits / 64 + bitOffset / 64 * 2 + (inBlock & 1);
+    return {word, static_cast<unsigned>(bitOffset % 64)};
+}
+
+} // namespace detail
+
+// Stored in the arena immediately before the packed words so a view can be
+// rebuilt from a mapped image with only the header's address
+struct packed_array_header {
+    uint64_t size;
+    uint64_t base;
+    uint32_t bits;
+    uint32_t valueSize; // sizeof(T), checked when reopened
+};
+static_assert(sizeof(packed_array_header) % sizeof(uint64_t) == 0);
+
+// Read view of a frame-of-reference, bit-packed array of unsigned integers
+// created with create::packed_array(). Each value is stored as (value - base)
+// in 'bits' bits in 64-bit words. Values are grouped in blocks of block_size
+// that start on a word boundary. Within a block, even and odd values are packed
+// into two interleaved lanes, so word k of lane l is at 2 * k + l. Both lanes
+// then hold a value at the same bit offset and a block is decoded two values
+// per SSE2 instruction with uniform shifts. Random access is a constant time
+// two-word read.
+template <std::unsigned_integral T>
+class packed_array_view {
+public:
+    static constexpr size_t block_size = 128;
+
+    packed_array_view() = default;
+
+    // Throws std::runtime_error if the header was written for a different T
+    // or is inconsistent, e.g. for a corrupt mapped file
+    explicit packed_array_view(const packed_array_header* header)
+        : m_header(header)
+        , m_words(reinterpret_cast<const uint64_t*>(header + 1))
+        , m_size(static_cast<size_t>(header->size))
+        , m_base(static_cast<T>(header->base))
+        , m_bits(header->bits) {
+        if (header->valueSize != sizeof(T) || m_bits > std::numeric_limits<T>::digits)
+            throw std::runtime_error("packed array header does not match its type");
+    }
+
+    [[nodiscard]] T operator[](size_t i) const {
+        assert(i < m_size);
+        return static_cast<T>(m_base + extract(i));
+    }
+
+    // Decodes the block_size values of block 'block' into 'out'. The last block
+    // may be partial, in which case only the remaining values are written.
+    void decode_block(size_t block, T* out) const {
+        size_t first = block * block_size;
+        assert(first < m_size);
+        size_t count = std::min(block_size, m_size - first);
+        if (count != block_size) {
+            for (size_t i = 0; i < count; ++i)
+                out[i] = static_cast<T>(m_base + extract(first + i));
+            return;
+        }
+#if defined(DECODELESS_PACKED_ARRAY_SSE2)
+        const uint64_t* words = m_words + block * block_size * m_bits / 64;
+        __m128i         mask = _mm_set1_epi64x(static_cast<long long>(value_mask()));
+        __m128i         base = _mm_set1_epi64x(static_cast<long long>(uint64_t(m_base)));
+        for (size_t pair = 0; pair < block_size / 2; ++pair) {
+            size_t  bitOffset = pair * m_bits;
+            size_t  word = bitOffset / 64 * 2;
+            int     shift = static_cast<int>(bitOffset % 64);
+            __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + word));
+            __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + word + 2));
+            // Split shift avoids losing the high word when shift == 0
+            __m128i value = _mm_or_si128(
+                _mm_srl_epi64(lo, _mm_cvtsi32_si128(shift)),
+                _mm_slli_epi64(_mm_sll_epi64(hi, _mm_cvtsi32_si128(63 - shift)), 1));
+            value = _mm_add_epi64(_mm_and_si128(value, mask), base);
+            if constexpr (sizeof(T) == sizeof(uint64_t)) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + pair * 2), value);
+            } else {
+                alignas(16) uint64_t pairValues[2];
+                _mm_store_si128(reinterpret_cast<__m128i*>(pairValues), value);
+                out[pair * 2] = static_cast<T>(pairValues[0]);
+                out[pair * 2 + 1] = static_cast<T>(pairValues[1]);
+            }
+        }
+#else
+        for (size_t i = 0; i < block_size; ++i)
+            out[i] = static_cast<T>(m_base + extract(first + i));
+#endif
+    }
+
+    // Decodes all values into 'out', which must hold size() values
+    void decode(std::span<T> out) const {
+        assert(out.size() >= m_size);
+        for (size_t block = 0; block * block_size < m_size; ++block)
+            decode_block(block, out.data() + block * block_size);
+    }
+
+    [[nodiscard]] size_t   size() const { return m_size; }
+    [[nodiscard]] bool     empty() const { return m_size == 0; }
+    [[nodiscard]] T        base() const { return m_base; }
+    [[nodiscard]] unsigned bits() const { return m_bits; }
+
+    // The header the view was created from, e.g. to record its offset in an
+    // image and reopen it with packed_array_view(header)
+    [[nodiscard]] const packed_array_header* header() const { return m_header; }
+
+    // Packed storage, including trailing padding words
+    [[nodiscard]] std::span<const uint64_t> words() const {
+        return {m_words, word_count(m_size, m_bits)};
+    }
+
+    // Number of words needed for 'size' values of 'bits' bits. Rounded up to
+    // whole blocks so every block starts on a word boundary, plus padding so
+    // extract() can always read the next word of its lane. With zero bits
+    // that is two words past the first word of each lane.
+    static constexpr size_t word_count(size_t size, unsigned bits) {
+        size_t blocks = (size + block_size - 1) / block_size;
+        return blocks * block_size * bits / 64 + (bits == 0 ? 4 : 2);
+    }
+
+    // Total bytes create::packed_array() allocates, including the header
+    static constexpr size_t allocation_size(size_t size, unsigned bits) {
+        return sizeof(packed_array_header) + word_count(size, bits) * sizeof(uint64_t);
+    }
+
+private:
+    uint64_t value_mask() const {
+        return m_bits == 64 ? ~uint64_t(0) : (uint64_t(1) << m_bits) - 1;
+    }
+
+    uint64_t extract(size_t i) const {
+        auto [word, shift] = detail::packed_position(i, m_bits);
+        // Split shift avoids UB when shift == 0
+        uint64_t value = (m_words[word] >> shift) | ((m_words[word + 2] << (63 - shift)) << 1);
+        return value & value_mask();
+    }
+
+    const packed_array_header* m_header = nullptr;
+    const uint64_t*            m_words = nullptr;
+    size_t                     m_size = 0;
+    T                          m_base = 0;
+    unsigned                   m_bits = 0;
+};
+
+namespace detail {
+
+// Packs 'range' into 'words', which must be zero initialized
+template <std::unsigned_integral T, class Range>
+void pack_values(Range&& range, std::span<uint64_t> words, T base, unsigned bits) {
+    size_t i = 0;
+    for (const auto& in : range) {
+        uint64_t value = static_cast<uint64_t>(static_cast<T>(in) - base);
+        auto [word, shift] = packed_position(i++, bits);
+        words[word] |= value << shift;
+        if (shift + bits > 64)
+            words[word + 2] |= value >> (64 - shift);
+    }
+}
+
+// Returns the frame of reference and the minimum bits to hold all offsets
+template <std::unsigned_integral T, class Range>
+std::pair<T, unsigned> pack_parameters(Range&& range) {
+    if (std::ranges::empty(range))
+        return {T(0), 0u};
+    auto [lo, hi] = std::ranges::minmax(range);
+    T    base = static_cast<T>(lo);
+    T    spread = static_cast<T>(static_cast<T>(hi) - base);
+    return {base, static_cast<unsigned>(std::bit_width(spread))};
+}
+
+} // namespace detail
+
+namespace create {
+
+namespace from_resource {
+
+// Bit packs a range of unsigned integers relative to its minimum value. 'bits'
+// defaults to the minimum needed for the range, or may be given explicitly,
+// e.g. to use the same width for multiple arrays.
+template <std::unsigned_integral T, std::ranges::forward_range Range,
+          memory_resource MemoryResource>
+    requires std::ranges::sized_range<Range> &&
+             std::convertible_to<std::ranges::range_value_t<Range>, T>
+packed_array_view<T> packed_array(MemoryResource& memoryResource, Range&& range,
+                                  unsigned bits = 0) {
+    auto [base, minBits] = detail::pack_parameters<T>(range);
+    if (bits == 0)
+        bits = minBits;
+    assert(bits >= minBits && bits <= std::numeric_limits<T>::digits);
+    size_t              size = std::ranges::size(range);
+    std::span<uint64_t> storage = array<uint64_t>(
+        memoryResource, packed_array_view<T>::allocation_size(size, bits) / sizeof(uint64_t));
+    auto* header = std::construct_at(reinterpret_cast<packed_array_header*>(storage.data()),
+                                     packed_array_header{size, base, bits, sizeof(T)});
+    detail::pack_values<T>(range, storage.subspan(sizeof(packed_array_header) / sizeof(uint64_t)),
+                           base, bits);
+    return packed_array_view<T>(header);
+}
+
+// Overload to deduce T from the Range type
+template <std::ranges::forward_range Range, memory_resource MemoryResource>
+    requires std::ranges::sized_range<Range> &&
+             std::unsigned_integral<std::ranges::range_value_t<Range>>
+auto packed_array(MemoryResource& memoryResource, Range&& range, unsigned bits = 0) {
+    return packed_array<std::ranges::range_value_t<Range>>(
+        memoryResource, std::forward<Range>(range), bits);
+}
+
+} // namespace from_resource
+
+namespace from_allocator {
+
+// Bit packs a range of unsigned integers relative to its minimum value
+template <std::unsigned_integral T, std::ranges::forward_range Range, allocator Allocator>
+    requires std::ranges::sized_range<Range> &&
+             std::convertible_to<std::ranges::range_value_t<Range>, T>
+packed_array_view<T> packed_array(const Allocator& allocator, Range&& range, unsigned bits = 0) {
+    auto [base, minBits] = detail::pack_parameters<T>(range);
+    if (bits == 0)
+        bits = minBits;
+    assert(bits >= minBits && bits <= std::numeric_limits<T>::digits);
+    size_t              size = std::ranges::size(range);
+    std::span<uint64_t> storage = array<uint64_t>(
+        allocator, packed_array_view<T>::allocation_size(size, bits) / sizeof(uint64_t));
+    auto* header = std::construct_at(reinterpret_cast<packed_array_header*>(storage.data()),
+                                     packed_array_header{size, base, bits, sizeof(T)});
+    detail::pack_values<T>(range, storage.subspan(sizeof(packed_array_header) / sizeof(uint64_t)),
+                           base, bits);
+    return packed_array_view<T>(header);
+}
+
+// Overload to deduce T from the Range type
+template <std::ranges::forward_range Range, allocator Allocator>
+    requires std::ranges::sized_range<Range> &&
+             std::unsigned_integral<std::ranges::range_value_t<Range>>
+auto packed_array(const Allocator& allocator, Range&& range, unsigned bits = 0) {
+    return packed_array<std::ranges::range_value_t<Range>>(allocator, std::forward<Range>(range),
+                                                           bits);
+}
+
+} // namespace from_allocator
+
+} // namespace create
+
+} // namespace decodeless
@@ -0,0 +1,43 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_WIN32)
+    // Keep windows.h from defining min() and max() macros
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace decodeless {
+
+// Returns the virtual memory page size, i.e. the granularity of protection and
+// residency for mapped memory.
+inline size_t page_size() {
+    static const size_t size = [] {
+#if defined(_WIN32)
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return static_cast<size_t>(info.dwPageSize);
+#else
+        return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    }();
+    return size;
+}
+
+// Rounds an address or size down/up to a power of two alignment.
+inline uintptr_t align_down(uintptr_t value, size_t align) {
+    return value & ~(uintptr_t(align) - 1);
+}
+inline uintptr_t align_up(uintptr_t value, size_t align) {
+    return (value + uintptr_t(align) - 1) & ~(uintptr_t(align) - 1);
+}
+
+} // namespace decodeless
@@ -0,0 +1,40 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace decodeless {
+
+// Returns the number of threads to use when the caller passes zero
+inline size_t default_thread_count() {
+    return std::max(size_t(1), static_cast<size_t>(std::thread::hardware_concurrency()));
+}
+
+// Calls f(begin, end) for contiguous chunks covering [0, count), one chunk per
+// thread. Chunk boundaries are multiples of 'granularity'. The calling thread
+// processes the first chunk and all threads are joined before returning. f
+// must not throw.
+template <class F>
+void parallel_for_chunks(size_t count, size_t threads, F&& f, size_t granularity = 1) {
+    if (threads == 0)
+        threads = default_thread_count();
+    size_t units = (count + granularity - 1) / granularity;
+    threads = std::max(size_t(1), std::min(threads, units));
+    size_t chunk = (units + threads - 1) / threads * granularity;
+    if (threads <= 1 || chunk >= count) {
+        if (count != 0)
+            f(size_t(0), count);
+        return;
+    }
+    std::vector<std::jthread> workers;
+    workers.reserve(threads - 1);
+    for (size_t begin = chunk; begin < count; begin += chunk)
+        workers.emplace_back([&f, begin, end = std::min(begin + chunk, count)] { f(begin, end); });
+    f(size_t(0), chunk);
+}
+
+} // namespace decodeless
@@ -0,0 +1,120 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <decodeless/allocator.hpp>
+#include <decodeless/byteswap.hpp>
+#include <decodeless/virtual_memory_resource.hpp>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+
+namespace decodeless {
+
+// File header written in front of a persistent_arena image
+struct persistent_arena_header {
+    static constexpr char     magic_value[8] = {'D', 'L', 'A', 'R', 'E', 'N', 'A', '1'};
+    char                      magic[8];
+    image_abi                 abi;
+    uint64_t                  base;
+    uint64_t                  size;
+    uint64_t                  reserved;
+};
+
+// A linear arena at a fixed virtual base address that can be saved to a file
+// and reloaded, ideally at the same address so raw pointers within it remain
+// valid. Contents must be trivially copyable and may only point within the
+// arena (or at other images loaded at fixed addresses). If the address range
+// is already taken when loading, the image is placed elsewhere and
+// relocation() gives the offset to apply to stored pointers, e.g. with
+// relocate().
+class persistent_arena {
+public:
+    using resource_type = linear_memory_resource<virtual_memory_resource>;
+
+    // Creates an empty arena that may grow to 'reserveSize' bytes. If 'base' is
+    // not null, the arena is placed exactly there or std::bad_alloc is thrown.
+    explicit persistent_arena(size_t reserveSize, void* base = nullptr)
+        : m_memory(virtual_memory_resource(reserveSize, base)) {}
+
+    // Loads an image saved with save(). The original base address is tried
+    // first, falling back to any address.
+    static persistent_arena load(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            throw std::runtime_error("failed to open " + path.string());
+        persistent_arena_header header;
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, persistent_arena_header::magic_value, sizeof(header.magic)))
+            throw std::runtime_error("not a persistent arena image: " + path.string());
+
+        // Raw pointers cannot be converted, so only native images can be loaded
+        if (header.abi != image_abi::host())
+            throw std::runtime_error("persistent arena image ABI mismatch: " + path.string());
+
+        void* savedBase = reinterpret_cast<void*>(static_cast<uintptr_t>(header.base));
+        std::optional<persistent_arena> result;
+        try {
+            result.emplace(static_cast<size_t>(header.reserved), savedBase);
+        } catch (const std::bad_alloc&) {
+            result.emplace(static_cast<size_t>(header.reserved));
+        }
+        result->m_savedBase = static_cast<uintptr_t>(header.base);
+        if (header.size != 0) {
+            void* data = result->m_memory.allocate(static_cast<size_t>(header.size), 1);
+            if (!file.read(static_cast<char*>(data), static_cast<std::streamsize>(header.size)))
+                throw std::runtime_error("truncated persistent arena image: " + path.string());
+        }
+        return std::move(*result);
+    }
+
+    // Writes the arena's base address, reservation size and all allocated
+    // bytes to 'path'.
+    void save(const std::filesystem::path& path) const {
+        persistent_arena_header header{};
+        std::memcpy(header.magic, persistent_arena_header::magic_value, sizeof(header.magic));
+        header.abi = image_abi::host();
+        header.base = reinterpret_cast<uintptr_t>(base());
+        header.size = m_memory.size();
+        header.reserved = m_memory.parent().max_size();
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(static_cast<const char*>(m_memory.data()),
+                   static_cast<std::streamsize>(m_memory.size()));
+        if (!file)
+            throw std::runtime_error("failed to write " + path.string());
+    }
+
+    // The arena to allocate from, e.g. with create::object()
+    [[nodiscard]] resource_type&       memory() { return m_memory; }
+    [[nodiscard]] const resource_type& memory() const { return m_memory; }
+
+    // Returns the fixed virtual address of the arena
+    [[nodiscard]] void* base() const { return m_memory.parent().base(); }
+
+    // Returns the byte offset between the address an image was saved from and
+    // where it was loaded. Zero if raw pointers are valid as-is.
+    [[nodiscard]] ptrdiff_t relocation() const {
+        return m_savedBase ? static_cast<ptrdiff_t>(reinterpret_cast<uintptr_t>(base()) -
+                                                    m_savedBase)
+                           : 0;
+    }
+
+    // Translates a pointer stored in the image to the loaded address
+    template <class T>
+    [[nodiscard]] T* relocate(T* saved) const {
+        if (!saved)
+            return saved;
+        return reinterpret_cast<T*>(reinterpret_cast<uintptr_t>(saved) + relocation());
+    }
+
+private:
+    resource_type m_memory;
+    uintptr_t     m_savedBase = 0;
+};
+
+} // namespace decodeless
@@ -0,0 +1,141 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <decodeless/allocator_concepts.hpp>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#if __has_include(<ranges>)
+    #include <ranges>
+#endif
+
+namespace decodeless {
+
+// Handles to objects and arrays requested from a placement_batch, resolved
+// with placement_batch::get() after place()
+template <class T>
+struct batch_object {
+    size_t index;
+};
+
+template <class T>
+struct batch_array {
+    size_t index;
+};
+
+// Collects object and array creations and places them all with a single
+// allocation, ordered by descending alignment. Sizes are multiples of their
+// alignment, so this leaves no padding between them regardless of the order
+// they were requested in, e.g. interleaved char arrays and doubles. Handles
+// refer to requests in their original order.
+template <memory_resource MemoryResource>
+class placement_batch {
+public:
+    explicit placement_batch(MemoryResource& memoryResource)
+        : m_resource(&memoryResource) {}
+
+    // Defers constructing a T from 'args', which are copied until place()
+    template <trivially_destructible T, class... Args>
+    batch_object<T> object(Args&&... args) {
+        static_assert(!std::is_const_v<T>, "const construction not allowed. cast instead");
+        auto construct = [... args = std::forward<Args>(args)](std::byte* p) {
+            std::construct_at(reinterpret_cast<T*>(p), args...);
+        };
+        return batch_object<T>{add(sizeof(T), alignof(T), 1, std::move(construct))};
+    }
+
+    // Defers default constructing an array of 'size' objects
+    template <trivially_destructible T>
+    batch_array<T> array(size_t size) {
+        static_assert(!std::is_const_v<T>, "const construction not allowed. cast instead");
+        return batch_array<T>{add(sizeof(T) * size, alignof(T), size, [size](std::byte* p) {
+            for (T& obj : std::span(reinterpret_cast<T*>(p), size))
+                std::construct_at(&obj);
+        })};
+    }
+
+#ifdef __cpp_lib_ranges
+    // Defers copy constructing an array from a range, which must remain valid
+    // until place()
+    template <trivially_destructible T, std::ranges::input_range Range>
+        requires std::convertible_to<std::ranges::range_value_t<Range>, T>
+    batch_array<T> array(const Range& range) {
+        static_assert(!std::is_const_v<T>, "const construction not allowed. cast instead");
+        size_t size = std::ranges::size(range);
+        return batch_array<T>{add(sizeof(T) * size, alignof(T), size, [&range](std::byte* p) {
+            T* out = reinterpret_cast<T*>(p);
+            for (const auto& in : range)
+                std::construct_at(out++, in);
+        })};
+    }
+#endif
+
+    // Makes one allocation for all requests and constructs them
+    void place() {
+        assert(!m_placed);
+        m_placed = true;
+        if (m_requests.empty())
+            return;
+        std::vector<size_t> order(m_requests.size());
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::ranges::stable_sort(order, std::greater{},
+                                 [this](size_t i) { return m_requests[i].align; });
+        auto* base = static_cast<std::byte*>(
+            m_resource->allocate(size(), m_requests[order.front()].align));
+        for (size_t i : order) {
+            m_requests[i].address = base;
+            m_requests[i].construct(base);
+            base += m_requests[i].size;
+        }
+    }
+
+    template <class T>
+    [[nodiscard]] T* get(batch_object<T> handle) const {
+        assert(m_placed);
+        return reinterpret_cast<T*>(m_requests[handle.index].address);
+    }
+
+    template <class T>
+    [[nodiscard]] std::span<T> get(batch_array<T> handle) const {
+        assert(m_placed);
+        const request& r = m_requests[handle.index];
+        return {reinterpret_cast<T*>(r.address), r.count};
+    }
+
+    // Bytes the single allocation needs
+    [[nodiscard]] size_t size() const {
+        size_t total = 0;
+        for (const request& r : m_requests)
+            total += r.size;
+        return total;
+    }
+
+private:
+    struct request {
+        size_t                          size;
+        size_t                          align;
+        size_t                          count;
+        std::function<void(std::byte*)> construct;
+        std::byte*                      address = nullptr;
+    };
+
+    size_t add(size_t size, size_t align, size_t count, std::function<void(std::byte*)> construct) {
+        assert(!m_placed);
+        assert(size % align == 0);
+        m_requests.push_back(request{size, align, count, std::move(construct)});
+        return m_requests.size() - 1;
+    }
+
+    MemoryResource*      m_resource;
+    std::vector<request> m_requests;
+    bool                 m_placed = false;
+};
+
+} // namespace decodeless
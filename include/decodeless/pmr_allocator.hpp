@@ -2,6 +2,9 @@
 
 #pragma once
 
+#include <cassert>
+#include <concepts>
+#include <cstddef>
 #include <decodeless/allocator.hpp>
 #include <memory_resource>
 
@@ -51,10 +54,59 @@ public:
         requires realloc_memory_resource<ParentAllocator>
         : base_type(std::move(parent)) {}
     void   reset() { this->backing_resource().reset(); }
+    void   rewind(size_t marker) { this->backing_resource().rewind(marker); }
     void   truncate() { this->backing_resource().truncate(); }
     void*  data() const { return this->backing_resource().data(); }
     size_t size() const { return this->backing_resource().size(); }
     size_t capacity() const { return this->backing_resource().capacity(); }
 };
 
+// Extension interface for std::pmr resources that can resize an allocation.
+// pmr_parent forwards it as reallocate(), which allows a linear_memory_resource
+// to grow. The result may differ from 'p' if the allocation moved.
+class pmr_realloc_memory_resource : public std::pmr::memory_resource {
+public:
+    [[nodiscard]] void* reallocate(void* p, std::size_t bytes, std::size_t align) {
+        return do_reallocate(p, bytes, align);
+    }
+
+private:
+    virtual void* do_reallocate(void* p, std::size_t bytes, std::size_t align) = 0;
+};
+
+// Non-owning reference to a std::pmr::memory_resource that satisfies the
+// decodeless memory_resource concept, e.g. to carve a linear_memory_resource
+// from a std::pmr::unsynchronized_pool_resource. std::pmr needs the allocation
+// alignment again on deallocation, which deallocate() does not receive, so all
+// allocations use the fixed alignment 'Align'.
+template <class PmrResource = std::pmr::memory_resource,
+          std::size_t Align = alignof(std::max_align_t)>
+    requires std::derived_from<PmrResource, std::pmr::memory_resource>
+class pmr_parent {
+public:
+    pmr_parent(PmrResource& resource)
+        : m_resource(&resource) {}
+
+    [[nodiscard]] void* allocate(std::size_t bytes, std::size_t align) {
+        assert(align <= Align);
+        (void)align;
+        return m_resource->allocate(bytes, Align);
+    }
+
+    [[nodiscard]] void* reallocate(void* p, std::size_t bytes, std::size_t align)
+        requires std::derived_from<PmrResource, pmr_realloc_memory_resource>
+    {
+        assert(align <= Align);
+        (void)align;
+        return m_resource->reallocate(p, bytes, Align);
+    }
+
+    void deallocate(void* p, std::size_t bytes) { m_resource->deallocate(p, bytes, Align); }
+
+    [[nodiscard]] PmrResource& resource() const { return *m_resource; }
+
+private:
+    PmrResource* m_resource;
+};
+
 } // namespace decodeless
@@ -0,0 +1,66 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <decodeless/page_size.hpp>
+#include <decodeless/parallel.hpp>
+#include <span>
+
+#if !defined(_WIN32)
+    #include <sys/mman.h>
+#endif
+
+namespace decodeless {
+
+// Faults in every page of a mapped range, e.g. a freshly mapped arena image
+// that will be mostly read. The range is split into one chunk per thread so
+// page faults and storage reads are issued concurrently rather than serially
+// on first access. Each thread uses MADV_POPULATE_READ where the kernel
+// supports it and otherwise reads one byte per page. With 'hugePages',
+// MADV_HUGEPAGE is applied first so transparent huge pages can back the range.
+// Pass zero threads to use all hardware threads.
+inline void prefetch_in_parallel(std::span<const std::byte> view, size_t threads = 0,
+                                 bool hugePages = false) {
+    if (view.empty())
+        return;
+    uintptr_t viewBegin = reinterpret_cast<uintptr_t>(view.data());
+    uintptr_t viewEnd = viewBegin + view.size();
+    uintptr_t begin = align_down(viewBegin, page_size());
+    uintptr_t end = align_up(viewEnd, page_size());
+#if defined(MADV_HUGEPAGE)
+    if (hugePages)
+        madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE);
+#endif
+
+    // Split on huge page boundaries when requested so threads don't fault in
+    // parts of the same huge page. Chunks are laid out from the huge page
+    // containing 'begin' and the first is clamped to start at 'begin'.
+    size_t    granularity = hugePages ? size_t(2) << 20 : page_size();
+    uintptr_t origin = align_down(begin, granularity);
+    parallel_for_chunks(
+        end - origin, threads,
+        [origin, begin, viewBegin, viewEnd](size_t chunkBegin, size_t chunkEnd) {
+            uintptr_t pagesBegin = std::max(origin + chunkBegin, begin);
+            uintptr_t pagesEnd = origin + chunkEnd;
+            if (pagesBegin >= pagesEnd)
+                return;
+#if defined(MADV_POPULATE_READ)
+            if (madvise(reinterpret_cast<void*>(pagesBegin), pagesEnd - pagesBegin,
+                        MADV_POPULATE_READ) == 0)
+                return;
+#endif
+            // Touch one byte per page, clamped to the view so bytes outside it
+            // are never read
+            uintptr_t first = std::max(pagesBegin, viewBegin);
+            uintptr_t last = std::min(pagesEnd, viewEnd);
+            for (uintptr_t addr = first; addr < last;
+                 addr = align_down(addr, page_size()) + page_size())
+                (void)*reinterpret_cast<const volatile std::byte*>(addr);
+        },
+        granularity);
+}
+
+} // namespace decodeless
@@ -0,0 +1,67 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <decodeless/page_size.hpp>
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+    #include <winioctl.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+#endif
+
+namespace decodeless {
+
+#if defined(_WIN32)
+using file_handle = HANDLE;
+#else
+using file_handle = int;
+#endif
+
+// Deallocates the storage behind [offset, offset + size) of an open file while
+// keeping its size, so the range reads as zero and dead data is never written
+// back. Intended for the decommit() of file-backed parents. Returns false if
+// the file system does not support it. On Windows the file must be sparse.
+inline bool punch_hole(file_handle file, uint64_t offset, uint64_t size) {
+    if (size == 0)
+        return true;
+#if defined(_WIN32)
+    FILE_ZERO_DATA_INFORMATION range;
+    range.FileOffset.QuadPart = static_cast<LONGLONG>(offset);
+    range.BeyondFinalZero.QuadPart = static_cast<LONGLONG>(offset + size);
+    DWORD returned;
+    return DeviceIoControl(file, FSCTL_SET_ZERO_DATA, &range, sizeof(range), nullptr, 0,
+                           &returned, nullptr) != 0;
+#elif defined(__linux__)
+    return fallocate(file, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, static_cast<off_t>(offset),
+                     static_cast<off_t>(size)) == 0;
+#else
+    (void)file;
+    (void)offset;
+    return false;
+#endif
+}
+
+// Frees the pages and file storage behind the whole pages within a shared file
+// mapping, e.g. when only the mapping and not the file descriptor is at hand.
+// Returns false where unsupported.
+inline bool punch_hole_mapped(void* p, size_t size) {
+#if defined(MADV_REMOVE)
+    uintptr_t begin = align_up(reinterpret_cast<uintptr_t>(p), page_size());
+    uintptr_t end = align_down(reinterpret_cast<uintptr_t>(p) + size, page_size());
+    return begin >= end || madvise(reinterpret_cast<void*>(begin), end - begin, MADV_REMOVE) == 0;
+#else
+    (void)p;
+    (void)size;
+    return false;
+#endif
+}
+
+} // namespace decodeless
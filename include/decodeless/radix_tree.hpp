@@ -0,0 +1,459 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <decodeless/allocator_concepts.hpp>
+#include <decodeless/allocator_construction.hpp>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+    #include <emmintrin.h>
+    #define DECODELESS_RADIX_TREE_SSE2 1
+#endif
+
+namespace decodeless {
+
+// Adaptive radix tree (ART) mapping byte string keys to uint64_t values. Nodes
+// are allocated from any decodeless memory resource, typically a
+// linear_memory_resource, and link to each other with self-relative offsets.
+// The tree can therefore be queried in place from a memory mapped file or an
+// image copied to any address, as long as all nodes live in the same mapping.
+// Inner nodes adapt between 4, 16, 48 and 256 children and use pessimistic
+// path compression for up to 8 prefix bytes, falling back to an optimistic
+// skip that is verified against the full key stored in each leaf.
+namespace radix_tree_detail {
+
+// Self-relative pointer. Zero is null since a link never points to itself.
+struct link {
+    int64_t offset = 0;
+
+    [[nodiscard]] const void* get() const {
+        return offset ? reinterpret_cast<const void*>(reinterpret_cast<uintptr_t>(this) +
+                                                      static_cast<uintptr_t>(offset))
+                      : nullptr;
+    }
+    [[nodiscard]] void* get() { return const_cast<void*>(std::as_const(*this).get()); }
+    void                set(const void* p) {
+        offset = p ? static_cast<int64_t>(reinterpret_cast<uintptr_t>(p) -
+                                          reinterpret_cast<uintptr_t>(this))
+                   : 0;
+    }
+};
+
+enum node_type : uint8_t { leaf_type, node4_type, node16_type, node48_type, node256_type };
+
+static constexpr size_t max_stored_prefix = 8;
+
+// Common inner node header. 'terminal' is the leaf for the key that ends at
+// this node, if any.
+struct node {
+    uint8_t  type;
+    uint8_t  reserved;
+    uint16_t count;
+    uint32_t prefixLength;
+    uint8_t  prefix[max_stored_prefix];
+    link     terminal;
+};
+
+struct node4 {
+    node    header;
+    uint8_t keys[4];
+    link    children[4];
+};
+
+struct node16 {
+    node    header;
+    uint8_t keys[16];
+    link    children[16];
+};
+
+// childIndex holds one plus the index into children, zero if empty
+struct node48 {
+    node    header;
+    uint8_t childIndex[256];
+    link    children[48];
+};
+
+struct node256 {
+    node header;
+    link children[256];
+};
+
+// Leaves store the full key, immediately following the header
+struct leaf {
+    uint8_t  type;
+    uint8_t  reserved[3];
+    uint32_t keyLength;
+    uint64_t value;
+
+    [[nodiscard]] std::string_view key() const {
+        return {reinterpret_cast<const char*>(this + 1), keyLength};
+    }
+};
+
+inline bool is_leaf(const void* p) { return *static_cast<const uint8_t*>(p) == leaf_type; }
+
+inline const link* find_child(const node* n, uint8_t byte) {
+    switch (n->type) {
+    case node4_type: {
+        auto* n4 = reinterpret_cast<const node4*>(n);
+        for (size_t i = 0; i < n->count; ++i)
+            if (n4->keys[i] == byte)
+                return &n4->children[i];
+        return nullptr;
+    }
+    case node16_type: {
+        auto* n16 = reinterpret_cast<const node16*>(n);
+#if defined(DECODELESS_RADIX_TREE_SSE2)
+        __m128i  keys = _mm_loadu_si128(reinterpret_cast<const __m128i*>(n16->keys));
+        __m128i  cmp = _mm_cmpeq_epi8(keys, _mm_set1_epi8(static_cast<char>(byte)));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(cmp)) & ((1u << n->count) - 1u);
+        return mask ? &n16->children[std::countr_zero(mask)] : nullptr;
+#else
+        for (size_t i = 0; i < n->count; ++i)
+            if (n16->keys[i] == byte)
+                return &n16->children[i];
+        return nullptr;
+#endif
+    }
+    case node48_type: {
+        auto*   n48 = reinterpret_cast<const node48*>(n);
+        uint8_t index = n48->childIndex[byte];
+        return index ? &n48->children[index - 1] : nullptr;
+    }
+    case node256_type: {
+        const link* child = &reinterpret_cast<const node256*>(n)->children[byte];
+        return child->offset ? child : nullptr;
+    }
+    }
+    assert(false);
+    return nullptr;
+}
+
+inline link* find_child(node* n, uint8_t byte) {
+    return const_cast<link*>(find_child(static_cast<const node*>(n), byte));
+}
+
+// Returns any leaf below 'p', used to recover prefix bytes that were not stored
+inline const leaf* any_leaf(const void* p) {
+    while (!is_leaf(p)) {
+        auto* n = static_cast<const node*>(p);
+        if (n->terminal.offset) {
+            p = n->terminal.get();
+            continue;
+        }
+        switch (n->type) {
+        case node4_type:
+            p = reinterpret_cast<const node4*>(n)->children[0].get();
+            break;
+        case node16_type:
+            p = reinterpret_cast<const node16*>(n)->children[0].get();
+            break;
+        case node48_type:
+            p = reinterpret_cast<const node48*>(n)->children[0].get();
+            break;
+        case node256_type: {
+            const link* child = reinterpret_cast<const node256*>(n)->children;
+            while (!child->offset)
+                ++child;
+            p = child->get();
+            break;
+        }
+        }
+    }
+    return static_cast<const leaf*>(p);
+}
+
+} // namespace radix_tree_detail
+
+// Root object of a radix tree, created as an ordinary object in the arena so
+// it can be located in a mapped image like any other.
+struct radix_tree_root {
+    radix_tree_detail::link root;
+    uint64_t                size = 0;
+};
+
+// Read-only queries of a radix tree, valid directly on a mapped image
+class radix_tree_view {
+public:
+    explicit radix_tree_view(const radix_tree_root& root)
+        : m_root(&root) {}
+
+    [[nodiscard]] std::optional<uint64_t> find(std::string_view key) const {
+        using namespace radix_tree_detail;
+        const void* p = m_root->root.get();
+        size_t      depth = 0;
+        while (p) {
+            if (is_leaf(p)) {
+                auto* l = static_cast<const leaf*>(p);
+                return l->key() == key ? std::optional<uint64_t>(l->value) : std::nullopt;
+            }
+            auto* n = static_cast<const node*>(p);
+            if (n->prefixLength) {
+                // Optimistically skip prefix bytes that were not stored. The
+                // leaf key comparison catches any mismatch.
+                if (key.size() < depth + n->prefixLength)
+                    return std::nullopt;
+                size_t stored = std::min<size_t>(n->prefixLength, max_stored_prefix);
+                if (std::memcmp(n->prefix, key.data() + depth, stored) != 0)
+                    return std::nullopt;
+                depth += n->prefixLength;
+            }
+            if (depth == key.size()) {
+                p = n->terminal.get();
+                continue;
+            }
+            const link* child = find_child(n, static_cast<uint8_t>(key[depth++]));
+            p = child ? child->get() : nullptr;
+        }
+        return std::nullopt;
+    }
+
+    [[nodiscard]] bool   contains(std::string_view key) const { return find(key).has_value(); }
+    [[nodiscard]] size_t size() const { return static_cast<size_t>(m_root->size); }
+    [[nodiscard]] bool   empty() const { return m_root->size == 0; }
+
+private:
+    const radix_tree_root* m_root;
+};
+
+// Incrementally builds a radix tree in a memory resource. Nodes that outgrow
+// their capacity are replaced by the next larger node type and the old node is
+// deallocated, which is a no-op for a linear_memory_resource.
+template <memory_resource MemoryResource>
+class radix_tree_builder {
+public:
+    explicit radix_tree_builder(MemoryResource& memoryResource)
+        : m_resource(&memoryResource)
+        , m_root(create::object<radix_tree_root>(memoryResource)) {}
+
+    // Inserts or replaces the value for 'key'. Returns true if the key is new.
+    bool insert(std::string_view key, uint64_t value) {
+        using namespace radix_tree_detail;
+        link*  ref = &m_root->root;
+        size_t depth = 0;
+        for (;;) {
+            void* p = ref->get();
+            if (!p) {
+                ref->set(make_leaf(key, value));
+                break;
+            }
+
+            // Lazy expansion: split a leaf only when another key reaches it
+            if (is_leaf(p)) {
+                auto*            existing = static_cast<leaf*>(p);
+                std::string_view existingKey = existing->key();
+                if (existingKey == key) {
+                    existing->value = value;
+                    return false;
+                }
+                size_t common = 0;
+                while (depth + common < key.size() && depth + common < existingKey.size() &&
+                       key[depth + common] == existingKey[depth + common])
+                    ++common;
+                auto* split = create::object<node4>(*m_resource);
+                split->header.type = node4_type;
+                set_prefix(&split->header, key.substr(depth, common));
+                add_at(split, existingKey, depth + common, existing);
+                add_at(split, key, depth + common, make_leaf(key, value));
+                ref->set(split);
+                break;
+            }
+
+            auto* n = static_cast<node*>(p);
+            if (n->prefixLength) {
+                size_t mismatch = prefix_mismatch(n, key, depth);
+                if (mismatch < n->prefixLength) {
+                    // Split the compressed path with a new parent node
+                    char full[max_stored_prefix];
+                    std::string_view oldPrefix =
+                        n->prefixLength <= max_stored_prefix
+                            ? std::string_view(
+                                  static_cast<const char*>(std::memcpy(full, n->prefix,
+                                                                       n->prefixLength)),
+                                  n->prefixLength)
+                            : any_leaf(n)->key().substr(depth, n->prefixLength);
+                    auto* split = create::object<node4>(*m_resource);
+                    split->header.type = node4_type;
+                    set_prefix(&split->header, key.substr(depth, mismatch));
+                    add_child(split, static_cast<uint8_t>(oldPrefix[mismatch]), n);
+                    set_prefix(n, oldPrefix.substr(mismatch + 1));
+                    add_at(split, key, depth + mismatch, make_leaf(key, value));
+                    ref->set(split);
+                    break;
+                }
+                depth += n->prefixLength;
+            }
+
+            if (depth == key.size()) {
+                if (n->terminal.offset) {
+                    static_cast<leaf*>(n->terminal.get())->value = value;
+                    return false;
+                }
+                n->terminal.set(make_leaf(key, value));
+                break;
+            }
+
+            link* child = find_child(n, static_cast<uint8_t>(key[depth]));
+            if (child) {
+                ref = child;
+                ++depth;
+                continue;
+            }
+            add_child(ref, n, static_cast<uint8_t>(key[depth]), make_leaf(key, value));
+            break;
+        }
+        ++m_root->size;
+        return true;
+    }
+
+    [[nodiscard]] const radix_tree_root& root() const { return *m_root; }
+    [[nodiscard]] radix_tree_view        view() const { return radix_tree_view(*m_root); }
+
+private:
+    radix_tree_detail::leaf* make_leaf(std::string_view key, uint64_t value) {
+        using radix_tree_detail::leaf;
+        void* memory = m_resource->allocate(sizeof(leaf) + key.size(), alignof(leaf));
+        leaf* result = std::construct_at(static_cast<leaf*>(memory));
+        result->type = radix_tree_detail::leaf_type;
+        result->keyLength = static_cast<uint32_t>(key.size());
+        result->value = value;
+        std::memcpy(result + 1, key.data(), key.size());
+        return result;
+    }
+
+    static void set_prefix(radix_tree_detail::node* n, std::string_view prefix) {
+        n->prefixLength = static_cast<uint32_t>(prefix.size());
+        std::memcpy(n->prefix, prefix.data(),
+                    std::min(prefix.size(), radix_tree_detail::max_stored_prefix));
+    }
+
+    // Returns the number of prefix bytes of 'n' matching 'key' from 'depth'
+    static size_t prefix_mismatch(const radix_tree_detail::node* n, std::string_view key,
+                                  size_t depth) {
+        using radix_tree_detail::max_stored_prefix;
+        size_t limit = std::min<size_t>(n->prefixLength, key.size() - depth);
+        size_t stored = std::min(limit, max_stored_prefix);
+        for (size_t i = 0; i < stored; ++i)
+            if (n->prefix[i] != static_cast<uint8_t>(key[depth + i]))
+                return i;
+        if (limit <= max_stored_prefix)
+            return limit;
+        std::string_view full = radix_tree_detail::any_leaf(n)->key();
+        for (size_t i = max_stored_prefix; i < limit; ++i)
+            if (full[depth + i] != key[depth + i])
+                return i;
+        return limit;
+    }
+
+    // Adds 'child' for 'key' to a new split node, as the terminal if the key
+    // ends at 'depth'
+    void add_at(radix_tree_detail::node4* split, std::string_view key, size_t depth, void* child) {
+        if (key.size() == depth)
+            split->header.terminal.set(child);
+        else
+            add_child(split, static_cast<uint8_t>(key[depth]), child);
+    }
+
+    // Adds to a node4 known to have space
+    static void add_child(radix_tree_detail::node4* n, uint8_t byte, void* child) {
+        assert(n->header.count < 4);
+        n->keys[n->header.count] = byte;
+        n->children[n->header.count].set(child);
+        ++n->header.count;
+    }
+
+    // Adds a child, replacing the node referenced by 'ref' with the next
+    // larger node type if it is full
+    void add_child(radix_tree_detail::link* ref, radix_tree_detail::node* n, uint8_t byte,
+                   void* child) {
+        using namespace radix_tree_detail;
+        switch (n->type) {
+        case node4_type: {
+            auto* n4 = reinterpret_cast<node4*>(n);
+            if (n->count < 4) {
+                add_child(n4, byte, child);
+                return;
+            }
+            auto* grown = create::object<node16>(*m_resource);
+            copy_header(&grown->header, n, node16_type);
+            for (size_t i = 0; i < 4; ++i) {
+                grown->keys[i] = n4->keys[i];
+                grown->children[i].set(n4->children[i].get());
+            }
+            replace(ref, n4, &grown->header);
+            n = &grown->header;
+            [[fallthrough]];
+        }
+        case node16_type: {
+            auto* n16 = reinterpret_cast<node16*>(n);
+            if (n->count < 16) {
+                n16->keys[n->count] = byte;
+                n16->children[n->count].set(child);
+                ++n->count;
+                return;
+            }
+            auto* grown = create::object<node48>(*m_resource);
+            copy_header(&grown->header, n, node48_type);
+            for (size_t i = 0; i < 16; ++i) {
+                grown->childIndex[n16->keys[i]] = static_cast<uint8_t>(i + 1);
+                grown->children[i].set(n16->children[i].get());
+            }
+            replace(ref, n16, &grown->header);
+            n = &grown->header;
+            [[fallthrough]];
+        }
+        case node48_type: {
+            auto* n48 = reinterpret_cast<node48*>(n);
+            if (n->count < 48) {
+                n48->childIndex[byte] = static_cast<uint8_t>(n->count + 1);
+                n48->children[n->count].set(child);
+                ++n->count;
+                return;
+            }
+            auto* grown = create::object<node256>(*m_resource);
+            copy_header(&grown->header, n, node256_type);
+            for (size_t i = 0; i < 256; ++i)
+                if (n48->childIndex[i])
+                    grown->children[i].set(n48->children[n48->childIndex[i] - 1].get());
+            replace(ref, n48, &grown->header);
+            n = &grown->header;
+            [[fallthrough]];
+        }
+        case node256_type:
+            reinterpret_cast<node256*>(n)->children[byte].set(child);
+            ++n->count;
+            return;
+        }
+    }
+
+    // Links are self-relative so headers are copied field by field
+    static void copy_header(radix_tree_detail::node* dst, const radix_tree_detail::node* src,
+                            radix_tree_detail::node_type type) {
+        dst->type = type;
+        dst->count = src->count;
+        dst->prefixLength = src->prefixLength;
+        std::memcpy(dst->prefix, src->prefix, sizeof(dst->prefix));
+        dst->terminal.set(src->terminal.get());
+    }
+
+    template <class Node>
+    void replace(radix_tree_detail::link* ref, Node* old, radix_tree_detail::node* grown) {
+        ref->set(grown);
+        m_resource->deallocate(old, sizeof(Node));
+    }
+
+    MemoryResource*  m_resource;
+    radix_tree_root* m_root;
+};
+
+} // namespace decodeless
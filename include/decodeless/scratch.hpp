@@ -0,0 +1,91 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <decodeless/allocator.hpp>
+#include <decodeless/virtual_memory_resource.hpp>
+#include <utility>
+
+#if !defined(DECODELESS_SCRATCH_RESERVE_SIZE)
+    // Address space reserved per scratch arena. Pages are committed on demand.
+    #define DECODELESS_SCRATCH_RESERVE_SIZE                                                        \
+        (sizeof(void*) >= 8 ? size_t(1) << 32 : size_t(64) << 20)
+#endif
+
+namespace decodeless {
+
+using scratch_resource = linear_memory_resource<virtual_memory_resource>;
+
+// Temporary allocations from a thread-local scratch arena, freed together when
+// the scope is destroyed by rewinding the arena to where it started. Satisfies
+// memory_resource, so create::array(scratch, ...) etc. work directly.
+class scratch_scope {
+public:
+    explicit scratch_scope(scratch_resource& resource)
+        : m_resource(&resource)
+        , m_marker(resource.size()) {}
+    scratch_scope(const scratch_scope& other) = delete;
+    scratch_scope(scratch_scope&& other) noexcept
+        : m_resource(std::exchange(other.m_resource, nullptr))
+        , m_marker(other.m_marker) {}
+    ~scratch_scope() {
+        if (m_resource)
+            m_resource->rewind(m_marker);
+    }
+    scratch_scope& operator=(const scratch_scope& other) = delete;
+    scratch_scope& operator=(scratch_scope&& other) = delete;
+
+    [[nodiscard]] void* allocate(std::size_t bytes, std::size_t align) {
+        return m_resource->allocate(bytes, align);
+    }
+    void deallocate(void* p, std::size_t bytes) { m_resource->deallocate(p, bytes); }
+
+    [[nodiscard]] scratch_resource& resource() const { return *m_resource; }
+
+private:
+    scratch_resource* m_resource;
+    size_t            m_marker;
+};
+
+namespace detail {
+
+inline scratch_resource* scratch_arenas() {
+    thread_local scratch_resource arenas[2]{
+        scratch_resource(virtual_memory_resource(DECODELESS_SCRATCH_RESERVE_SIZE)),
+        scratch_resource(virtual_memory_resource(DECODELESS_SCRATCH_RESERVE_SIZE))};
+    return arenas;
+}
+
+template <class Resource>
+const void* conflict_address(const Resource& resource) {
+    return &resource;
+}
+
+inline const void* conflict_address(const scratch_scope& scope) { return &scope.resource(); }
+
+} // namespace detail
+
+// Returns a scope over one of two thread-local scratch arenas for temporary
+// allocations. Pass the resources the caller is producing output into, e.g.
+// an output arena that may itself be a scratch arena of an enclosing caller.
+// The other arena is picked so temporaries never interleave with, and are
+// never rewound over, that output:
+//
+//   std::span<int> compute(scratch_scope& output) {
+//       scratch_scope temp = scratch(output);
+//       ... temporaries in temp, results in output ...
+//   }
+template <class... Conflicts>
+[[nodiscard]] scratch_scope scratch(const Conflicts&... conflicts) {
+    scratch_resource* arenas = detail::scratch_arenas();
+    for (size_t i = 0; i < 2; ++i) {
+        if (!((detail::conflict_address(conflicts) == &arenas[i]) || ...))
+            return scratch_scope(arenas[i]);
+    }
+    assert(!"both scratch arenas are in use by the caller");
+    return scratch_scope(arenas[0]);
+}
+
+} // namespace decodeless
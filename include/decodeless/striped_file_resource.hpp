@@ -0,0 +1,268 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+// Requires MAP_FIXED over a reservation, so POSIX only for now. Windows would
+// need MapViewOfFile3() with placeholders.
+#if !defined(_WIN32)
+
+    #include <algorithm>
+    #include <atomic>
+    #include <cassert>
+    #include <cstddef>
+    #include <cstdint>
+    #include <cstring>
+    #include <decodeless/allocator.hpp>
+    #include <decodeless/page_size.hpp>
+    #include <decodeless/parallel.hpp>
+    #include <decodeless/punch_hole.hpp>
+    #include <decodeless/virtual_memory_resource.hpp>
+    #include <fcntl.h>
+    #include <filesystem>
+    #include <new>
+    #include <optional>
+    #include <span>
+    #include <stdexcept>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #include <utility>
+    #include <vector>
+
+namespace decodeless {
+
+namespace detail {
+
+// Owns the file descriptors of a set of stripe files
+class stripe_files {
+public:
+    stripe_files(std::span<const std::filesystem::path> paths, int flags) {
+        if (paths.empty())
+            throw std::runtime_error("no stripe files given");
+        for (const std::filesystem::path& path : paths) {
+            int fd = ::open(path.c_str(), flags, 0644);
+            if (fd < 0)
+                throw std::runtime_error("failed to open " + path.string());
+            m_fds.push_back(fd);
+        }
+    }
+    stripe_files(const stripe_files& other) = delete;
+    stripe_files(stripe_files&& other) noexcept
+        : m_fds(std::move(other.m_fds)) {}
+    ~stripe_files() { close(); }
+    stripe_files& operator=(const stripe_files& other) = delete;
+    stripe_files& operator=(stripe_files&& other) noexcept {
+        close();
+        m_fds = std::move(other.m_fds);
+        return *this;
+    }
+
+    [[nodiscard]] int    operator[](size_t i) const { return m_fds[i]; }
+    [[nodiscard]] size_t size() const { return m_fds.size(); }
+
+private:
+    void close() {
+        for (int fd : m_fds)
+            ::close(fd);
+        m_fds.clear();
+    }
+
+    std::vector<int> m_fds;
+};
+
+} // namespace detail
+
+// A growable memory_resource presenting one contiguous virtual range whose
+// stripes are mapped round robin from several files, e.g. one per NVMe drive.
+// Stripe i is stored in file i % N at offset (i / N) * stripeSize and mapped
+// with MAP_FIXED into a reserved range, so it grows in place like
+// virtual_memory_resource. Writeback is spread across all devices and flush()
+// syncs each file from its own thread. Files are created or truncated and
+// always hold whole stripes. Read the image back with striped_file_reader.
+// Only one allocation may exist at a time.
+class striped_file_resource {
+public:
+    // Capabilities, see allocator_concepts.hpp
+    static constexpr bool address_stable = true;
+    static constexpr bool page_aligned = true;
+
+    // 'stripeSize' must be a multiple of the page size. Up to 'reserveSize'
+    // bytes of address space are reserved.
+    striped_file_resource(std::span<const std::filesystem::path> files, size_t stripeSize,
+                          size_t reserveSize)
+        : m_files(files, O_RDWR | O_CREAT | O_TRUNC)
+        , m_reservation((reserveSize + stripeSize - 1) / stripeSize * stripeSize)
+        , m_stripeSize(stripeSize) {
+        assert(stripeSize != 0 && stripeSize % page_size() == 0);
+    }
+
+    [[nodiscard]] void* allocate(std::size_t bytes, std::size_t align) {
+        assert(m_stripes == 0);
+        assert(align <= page_size());
+        (void)align;
+        if (!try_expand(base(), bytes))
+            throw std::bad_alloc();
+        return base();
+    }
+
+    // Maps more stripes as needed. Never moves and never unmaps stripes.
+    [[nodiscard]] void* reallocate(void* ptr, std::size_t bytes, std::size_t align) {
+        assert(align <= page_size());
+        (void)align;
+        if (!try_expand(ptr, bytes))
+            throw std::bad_alloc();
+        return ptr;
+    }
+
+    [[nodiscard]] bool try_expand(void* ptr, std::size_t bytes) {
+        assert(ptr == base());
+        (void)ptr;
+        size_t stripes = (bytes + m_stripeSize - 1) / m_stripeSize;
+        if (stripes * m_stripeSize > m_reservation.max_size())
+            return false;
+        for (; m_stripes < stripes; ++m_stripes) {
+            size_t file = m_stripes % m_files.size();
+            off_t  offset = static_cast<off_t>(m_stripes / m_files.size() * m_stripeSize);
+            if (ftruncate(m_files[file], offset + static_cast<off_t>(m_stripeSize)) != 0 ||
+                mmap(stripe(m_stripes), m_stripeSize, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_FIXED, m_files[file], offset) == MAP_FAILED)
+                return false;
+        }
+        return true;
+    }
+
+    // Unmaps all stripes, keeping the files and the reservation
+    void deallocate(void* ptr, std::size_t bytes) {
+        assert(ptr == base());
+        (void)ptr;
+        (void)bytes;
+        if (m_stripes != 0)
+            mmap(base(), m_stripes * m_stripeSize, PROT_NONE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+        m_stripes = 0;
+    }
+
+    // Releases the file storage and pages behind the whole pages within
+    // [ptr, ptr + bytes) with punch_hole(). They stay mapped and read as zero.
+    // Where the file system cannot punch holes they are zeroed instead.
+    void decommit(void* ptr, std::size_t bytes) {
+        uintptr_t origin = reinterpret_cast<uintptr_t>(base());
+        uintptr_t first = align_up(reinterpret_cast<uintptr_t>(ptr), page_size());
+        uintptr_t last = std::min(align_down(reinterpret_cast<uintptr_t>(ptr) + bytes, page_size()),
+                                  origin + m_stripes * m_stripeSize);
+        if (first >= last)
+            return;
+        for (size_t offset = first - origin; offset < last - origin;) {
+            size_t s = offset / m_stripeSize;
+            size_t within = offset % m_stripeSize;
+            size_t length = std::min(size_t(last - origin - offset), m_stripeSize - within);
+            if (!punch_hole(m_files[s % m_files.size()], s / m_files.size() * m_stripeSize + within,
+                            length))
+                std::memset(stripe(s) + within, 0, length);
+            offset += length;
+        }
+    }
+
+    // Writes back [ptr, ptr + size) and waits for it to be durable, syncing
+    // each file from its own thread
+    void flush(std::byte* ptr, std::size_t size) {
+        if (size == 0)
+            return;
+        uintptr_t         begin = align_down(reinterpret_cast<uintptr_t>(ptr), page_size());
+        uintptr_t         end = reinterpret_cast<uintptr_t>(ptr) + size;
+        uintptr_t         origin = reinterpret_cast<uintptr_t>(base());
+        size_t            firstStripe = (begin - origin) / m_stripeSize;
+        size_t            lastStripe = (end - origin - 1) / m_stripeSize;
+        std::atomic<bool> failed = false;
+        parallel_for_chunks(m_files.size(), m_files.size(), [&](size_t first, size_t last) {
+            for (size_t file = first; file < last; ++file) {
+                // First stripe at or after firstStripe stored in 'file'
+                size_t s = firstStripe + (file + m_files.size() - firstStripe % m_files.size()) %
+                                             m_files.size();
+                for (; s <= lastStripe; s += m_files.size()) {
+                    uintptr_t from = std::max(begin, reinterpret_cast<uintptr_t>(stripe(s)));
+                    uintptr_t to = std::min(end, reinterpret_cast<uintptr_t>(stripe(s + 1)));
+                    if (msync(reinterpret_cast<void*>(from), to - from, MS_SYNC) != 0)
+                        failed = true;
+                }
+            }
+        });
+        if (failed)
+            throw std::runtime_error("msync() failed");
+    }
+
+    // The reservation size. A linear_memory_resource uses this to clamp
+    // capacity doubling.
+    [[nodiscard]] size_t max_size() const { return m_reservation.max_size(); }
+
+    [[nodiscard]] void*  base() const { return m_reservation.base(); }
+    [[nodiscard]] size_t stripe_size() const { return m_stripeSize; }
+    [[nodiscard]] size_t stripe_count() const { return m_stripes; }
+    [[nodiscard]] size_t file_count() const { return m_files.size(); }
+
+private:
+    std::byte* stripe(size_t i) const { return static_cast<std::byte*>(base()) + i * m_stripeSize; }
+
+    detail::stripe_files    m_files;
+    virtual_memory_resource m_reservation;
+    size_t                  m_stripeSize;
+    size_t                  m_stripes = 0;
+};
+
+// Growable linear arena striped across multiple files
+using striped_linear_resource = linear_memory_resource<striped_file_resource>;
+
+// Maps files written by a striped_file_resource back into one contiguous,
+// read-only range with the same layout
+class striped_file_reader {
+public:
+    striped_file_reader(std::span<const std::filesystem::path> files, size_t stripeSize)
+        : m_files(files, O_RDONLY) {
+        assert(stripeSize != 0 && stripeSize % page_size() == 0);
+
+        // Stripes are written round robin, so earlier files hold the same
+        // number of stripes as later ones or one more
+        std::vector<size_t> counts;
+        for (size_t file = 0; file < m_files.size(); ++file) {
+            struct stat info;
+            if (fstat(m_files[file], &info) != 0 ||
+                static_cast<size_t>(info.st_size) % stripeSize != 0)
+                throw std::runtime_error("invalid stripe file " + files[file].string());
+            counts.push_back(static_cast<size_t>(info.st_size) / stripeSize);
+        }
+        size_t stripes = 0;
+        for (size_t count : counts)
+            stripes += count;
+        for (size_t file = 0; file < counts.size(); ++file)
+            if (counts[file] != (stripes + counts.size() - 1 - file) / counts.size())
+                throw std::runtime_error("inconsistent stripe files");
+
+        m_size = stripes * stripeSize;
+        if (m_size == 0)
+            return;
+        m_reservation.emplace(virtual_memory_resource(m_size));
+        auto* base = static_cast<std::byte*>(m_reservation->base());
+        for (size_t s = 0; s < stripes; ++s) {
+            off_t offset = static_cast<off_t>(s / m_files.size() * stripeSize);
+            if (mmap(base + s * stripeSize, stripeSize, PROT_READ, MAP_SHARED | MAP_FIXED,
+                     m_files[s % m_files.size()], offset) == MAP_FAILED)
+                throw std::runtime_error("failed to map stripe");
+        }
+    }
+
+    // All stripes, including any unused tail of the last one
+    [[nodiscard]] std::span<const std::byte> data() const {
+        if (m_size == 0)
+            return {};
+        return {static_cast<const std::byte*>(m_reservation->base()), m_size};
+    }
+
+private:
+    detail::stripe_files                   m_files;
+    std::optional<virtual_memory_resource> m_reservation;
+    size_t                                 m_size = 0;
+};
+
+} // namespace decodeless
+
+#endif
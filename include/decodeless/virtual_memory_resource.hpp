@@ -0,0 +1,197 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <decodeless/page_size.hpp>
+#include <new>
+#include <utility>
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+#endif
+
+namespace decodeless {
+
+// A reallocating memory_resource backed by a range of reserved virtual address
+// space. Pages are committed on demand so the single allocation it provides
+// can grow in place up to the reservation size, i.e. reallocate() always
+// returns the same address. This makes it an ideal parent for a growable
+// linear_memory_resource. The base address can be requested explicitly, e.g.
+// to reload an image with raw pointers at the address it was written from.
+class virtual_memory_resource {
+public:
+    // Capabilities, see allocator_concepts.hpp
+    static constexpr bool zero_filled = true;
+    static constexpr bool address_stable = true;
+    static constexpr bool page_aligned = true;
+
+    // Reserves 'reserveSize' bytes anywhere in the address space
+    explicit virtual_memory_resource(size_t reserveSize)
+        : virtual_memory_resource(reserveSize, nullptr) {}
+
+    // Reserves 'reserveSize' bytes at exactly 'base'. Existing mappings are
+    // never replaced and std::bad_alloc is thrown if the range is taken.
+    virtual_memory_resource(size_t reserveSize, void* base)
+        : m_reserved(align_up(reserveSize, page_size())) {
+        m_base = reserve(base, m_reserved);
+        if (!m_base)
+            throw std::bad_alloc();
+    }
+
+    virtual_memory_resource(const virtual_memory_resource& other) = delete;
+    virtual_memory_resource(virtual_memory_resource&& other) noexcept
+        : m_base(std::exchange(other.m_base, nullptr))
+        , m_reserved(std::exchange(other.m_reserved, 0))
+        , m_committed(std::exchange(other.m_committed, 0)) {}
+    ~virtual_memory_resource() { release(); }
+    virtual_memory_resource& operator=(const virtual_memory_resource& other) = delete;
+    virtual_memory_resource& operator=(virtual_memory_resource&& other) noexcept {
+        release();
+        m_base = std::exchange(other.m_base, nullptr);
+        m_reserved = std::exchange(other.m_reserved, 0);
+        m_committed = std::exchange(other.m_committed, 0);
+        return *this;
+    }
+
+    // Returns the reservation base. Only one allocation may exist at a time.
+    [[nodiscard]] void* allocate(std::size_t bytes, std::size_t align) {
+        assert(m_committed == 0);
+        assert(align <= page_size());
+        (void)align;
+        return reallocate(m_base, bytes, align);
+    }
+
+    // Commits or decommits pages so that exactly 'bytes' are usable. Always
+    // returns the same address or throws std::bad_alloc if the reservation is
+    // exhausted.
+    [[nodiscard]] void* reallocate(void* ptr, std::size_t bytes, std::size_t align) {
+        assert(ptr == m_base);
+        (void)ptr;
+        (void)align;
+        size_t committed = align_up(bytes, page_size());
+        if (committed > m_reserved)
+            throw std::bad_alloc();
+        if (committed > m_committed) {
+            if (!commit(static_cast<std::byte*>(m_base) + m_committed, committed - m_committed))
+                throw std::bad_alloc();
+        } else if (committed < m_committed) {
+            uncommit(static_cast<std::byte*>(m_base) + committed, m_committed - committed);
+        }
+        m_committed = committed;
+        return m_base;
+    }
+
+    // Commits pages so that at least 'bytes' are usable, returning false
+    // instead of throwing if the reservation is exhausted
+    [[nodiscard]] bool try_expand(void* ptr, std::size_t bytes) {
+        assert(ptr == m_base);
+        (void)ptr;
+        size_t committed = align_up(bytes, page_size());
+        if (committed <= m_committed)
+            return true;
+        if (committed > m_reserved ||
+            !commit(static_cast<std::byte*>(m_base) + m_committed, committed - m_committed))
+            return false;
+        m_committed = committed;
+        return true;
+    }
+
+    // Releases the physical pages within [ptr, ptr + bytes) that are wholly
+    // covered. They remain committed and read as zero when next touched.
+    void decommit(void* ptr, std::size_t bytes) {
+        uintptr_t begin = align_up(reinterpret_cast<uintptr_t>(ptr), page_size());
+        uintptr_t end = align_down(reinterpret_cast<uintptr_t>(ptr) + bytes, page_size());
+        if (begin >= end)
+            return;
+#if defined(_WIN32)
+        VirtualFree(reinterpret_cast<void*>(begin), end - begin, MEM_DECOMMIT);
+        VirtualAlloc(reinterpret_cast<void*>(begin), end - begin, MEM_COMMIT, PAGE_READWRITE);
+#else
+        madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+#endif
+    }
+
+    void deallocate(void* p, std::size_t bytes) {
+        assert(p == m_base);
+        (void)p;
+        (void)bytes;
+        uncommit(m_base, m_committed);
+        m_committed = 0;
+    }
+
+    // The reservation size. A linear_memory_resource uses this to clamp
+    // capacity doubling.
+    [[nodiscard]] size_t max_size() const { return m_reserved; }
+
+    [[nodiscard]] void*  base() const { return m_base; }
+    [[nodiscard]] size_t committed() const { return m_committed; }
+
+private:
+    static void* reserve(void* base, size_t size) {
+#if defined(_WIN32)
+        // VirtualAlloc() fails rather than replacing an existing mapping
+        return VirtualAlloc(base, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+    #if defined(MAP_FIXED_NOREPLACE)
+        if (base)
+            flags |= MAP_FIXED_NOREPLACE;
+    #endif
+        void* result = mmap(base, size, PROT_NONE, flags, -1, 0);
+        if (result == MAP_FAILED)
+            return nullptr;
+
+        // Without MAP_FIXED_NOREPLACE, or on kernels older than 4.17 that
+        // ignore it, the address is only a hint
+        if (base && result != base) {
+            munmap(result, size);
+            return nullptr;
+        }
+        return result;
+#endif
+    }
+
+    static bool commit(void* p, size_t size) {
+#if defined(_WIN32)
+        return VirtualAlloc(p, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+        return mprotect(p, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+    }
+
+    static void uncommit(void* p, size_t size) {
+        if (size == 0)
+            return;
+#if defined(_WIN32)
+        VirtualFree(p, size, MEM_DECOMMIT);
+#else
+        madvise(p, size, MADV_DONTNEED);
+        mprotect(p, size, PROT_NONE);
+#endif
+    }
+
+    void release() {
+        if (!m_base)
+            return;
+#if defined(_WIN32)
+        VirtualFree(m_base, 0, MEM_RELEASE);
+#else
+        munmap(m_base, m_reserved);
+#endif
+        m_base = nullptr;
+    }
+
+    void*  m_base = nullptr;
+    size_t m_reserved = 0;
+    size_t m_committed = 0;
+};
+
+} // namespace decodeless
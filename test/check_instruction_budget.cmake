@@ -0,0 +1,45 @@
+# Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+# Disassembles OBJECT with OBJDUMP and fails if any function in the comma
+# separated SYMBOLS has more than BUDGET instructions. Cold sections split out
+# by the compiler, e.g. "<symbol>.cold", are not counted. Usage:
+#   cmake -DOBJDUMP=... -DOBJECT=... -DBUDGET=16 -DSYMBOLS=a,b
+#         -P check_instruction_budget.cmake
+
+execute_process(
+  COMMAND ${OBJDUMP} -d --no-show-raw-insn ${OBJECT}
+  OUTPUT_VARIABLE disassembly
+  RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "${OBJDUMP} failed on ${OBJECT}")
+endif()
+
+string(REPLACE "," ";" SYMBOLS "${SYMBOLS}")
+string(REPLACE "\n" ";" lines "${disassembly}")
+foreach(symbol IN LISTS SYMBOLS)
+  set(inside FALSE)
+  set(found FALSE)
+  set(count 0)
+  foreach(line IN LISTS lines)
+    if(line MATCHES "^[0-9a-fA-F]+ <([^>]+)>:")
+      if(CMAKE_MATCH_1 STREQUAL symbol)
+        set(inside TRUE)
+        set(found TRUE)
+      else()
+        set(inside FALSE)
+      endif()
+    elseif(inside AND line MATCHES "^ *[0-9a-fA-F]+:[ \t]+([a-z0-9.]+)")
+      # Skip alignment padding
+      if(NOT CMAKE_MATCH_1 MATCHES "^(nop|data16|xchg|int3)")
+        math(EXPR count "${count} + 1")
+      endif()
+    endif()
+  endforeach()
+  if(NOT found)
+    message(FATAL_ERROR "${symbol} not found in ${OBJECT}")
+  endif()
+  message(STATUS "${symbol}: ${count} instructions (budget ${BUDGET})")
+  if(count GREATER BUDGET)
+    message(FATAL_ERROR "${symbol} exceeds its instruction budget")
+  endif()
+endforeach()
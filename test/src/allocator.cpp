@@ -1,18 +1,55 @@
 // Copyright (c) 2024 Pyarelal Knowles, MIT License
 
+#include "embedded_table.hpp"
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <decodeless/allocate_parallel.hpp>
 #include <decodeless/allocator.hpp>
 #include <decodeless/allocator_construction.hpp>
+#include <decodeless/arena_format.hpp>
+#include <decodeless/arena_handle.hpp>
+#include <decodeless/byteswap.hpp>
+#include <decodeless/cache_coloring.hpp>
+#include <decodeless/commit.hpp>
+#include <decodeless/csr_graph.hpp>
+#include <decodeless/dirty_tracker.hpp>
+#include <decodeless/double_ended_resource.hpp>
+#include <decodeless/embedded_arena.hpp>
+#include <decodeless/freeze.hpp>
+#include <decodeless/large_object_resource.hpp>
+#include <decodeless/malloc_expand_parent.hpp>
+#include <decodeless/packed_array.hpp>
+#include <decodeless/persistent_arena.hpp>
+#include <decodeless/placement_batch.hpp>
 #include <decodeless/pmr_allocator.hpp>
+#include <decodeless/prefetch.hpp>
+#include <decodeless/punch_hole.hpp>
+#include <decodeless/radix_tree.hpp>
+#include <decodeless/scratch.hpp>
+#include <decodeless/striped_file_resource.hpp>
+#include <filesystem>
+#include <fstream>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <initializer_list>
+#include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
+
+#if defined(__linux__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
 
 using namespace decodeless;
 
@@ -386,6 +423,63 @@ TEST_F(Allocate, PmrVectorRelaxed) {
     EXPECT_THROW(vec.reserve(100), std::bad_alloc);
 }
 
+static_assert(nonrealloc_memory_resource<pmr_parent<>>);
+static_assert(realloc_memory_resource<pmr_parent<pmr_realloc_memory_resource>>);
+
+TEST_F(Allocate, PmrParent) {
+    alignas(std::max_align_t) std::byte buffer[1024];
+    std::pmr::monotonic_buffer_resource pool(buffer, sizeof(buffer),
+                                             std::pmr::null_memory_resource());
+    linear_memory_resource<pmr_parent<>> memory(100, pmr_parent<>(pool));
+    std::span<uint8_t>                   bytes = create::array<uint8_t>(memory, 10);
+    EXPECT_GE(reinterpret_cast<std::byte*>(bytes.data()), buffer);
+    EXPECT_LT(reinterpret_cast<std::byte*>(bytes.data()), buffer + sizeof(buffer));
+    EXPECT_THROW((void)create::array<uint8_t>(memory, 100), std::bad_alloc);
+}
+
+// Grows a single allocation in place within a fixed buffer
+class InPlacePmrResource : public pmr_realloc_memory_resource {
+public:
+    alignas(std::max_align_t) std::byte buffer[1024];
+    size_t                              size = 0;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t align) override {
+        EXPECT_EQ(align, alignof(std::max_align_t));
+        return do_reallocate(buffer, bytes, align);
+    }
+    void* do_reallocate(void* p, std::size_t bytes, std::size_t align) override {
+        EXPECT_EQ(p, buffer);
+        EXPECT_EQ(align, alignof(std::max_align_t));
+        if (bytes > sizeof(buffer))
+            throw std::bad_alloc();
+        size = bytes;
+        return buffer;
+    }
+    void do_deallocate(void* p, std::size_t bytes, std::size_t align) override {
+        EXPECT_EQ(p, buffer);
+        EXPECT_EQ(bytes, size);
+        EXPECT_EQ(align, alignof(std::max_align_t));
+        size = 0;
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+TEST_F(Allocate, PmrParentRealloc) {
+    InPlacePmrResource resource;
+    {
+        linear_memory_resource<pmr_parent<InPlacePmrResource>> memory(
+            pmr_parent<InPlacePmrResource>{resource});
+        (void)create::array<uint8_t>(memory, 10);
+        (void)create::array<uint8_t>(memory, 100);
+        EXPECT_EQ(memory.data(), resource.buffer);
+        EXPECT_EQ(resource.size, memory.capacity());
+    }
+    EXPECT_EQ(resource.size, 0);
+}
+
 TEST_F(Allocate, ArrayFromView) {
     using namespace std::views;
     auto                   running_sum = [l = 0](int i) mutable { return std::exchange(l, l + i); };
@@ -760,3 +854,1147 @@ TEST(Construct, Allocator) {
     EXPECT_EQ(*decodeless::create::object<int2>(allocator, 42, 42), int2(42, 42));
     EXPECT_EQ(*decodeless::create::object<int2>(allocator, int2(42, 42)), int2(42, 42));
 }
+
+// Simulates a file mapping: always hands out the same existing buffer and
+// records flush() calls
+struct FlushRecordingAllocator {
+    using value_type = std::byte;
+    value_type* allocate(std::size_t n) {
+        EXPECT_LE(n, file->size());
+        return file->data();
+    }
+    void deallocate(value_type* p, std::size_t) noexcept { EXPECT_EQ(p, file->data()); }
+    void flush(value_type* p, std::size_t n) {
+        flushes->emplace_back(static_cast<size_t>(p - file->data()), n);
+    }
+    std::vector<std::byte>*                 file;
+    std::vector<std::pair<size_t, size_t>>* flushes;
+};
+
+static_assert(has_flush<FlushRecordingAllocator>);
+static_assert(!has_flush<std::allocator<std::byte>>);
+
+TEST(Commit, FlushesAppendedRange) {
+    std::vector<std::byte>                 file(1024);
+    std::vector<std::pair<size_t, size_t>> flushes;
+    linear_memory_resource<FlushRecordingAllocator> memory(file.size(),
+                                                          FlushRecordingAllocator{&file, &flushes});
+    commit_header*                                  header = create_commit_header(memory);
+    EXPECT_EQ(header->committedSize, 0);
+
+    (void)create::array<int>(memory, {1, 2, 3});
+    commit(memory, *header);
+    EXPECT_EQ(header->committedSize, memory.size());
+    using range = std::pair<size_t, size_t>;
+    EXPECT_THAT(flushes, testing::ElementsAre(range{0, memory.size()},
+                                              range{0, sizeof(commit_header)}));
+
+    // Only the newly appended bytes are flushed on the next commit
+    flushes.clear();
+    size_t committed = memory.size();
+    (void)create::object<double>(memory, 42.0);
+    commit(memory, *header);
+    EXPECT_THAT(flushes, testing::ElementsAre(range{committed, memory.size() - committed},
+                                              range{0, sizeof(commit_header)}));
+
+    // Nothing new, nothing flushed
+    flushes.clear();
+    commit(memory, *header);
+    EXPECT_TRUE(flushes.empty());
+}
+
+TEST(Commit, Recover) {
+    std::vector<std::byte>                 file(1024);
+    std::vector<std::pair<size_t, size_t>> flushes;
+    size_t                                 committed;
+    {
+        linear_memory_resource<FlushRecordingAllocator> memory(
+            file.size(), FlushRecordingAllocator{&file, &flushes});
+        commit_header* header = create_commit_header(memory);
+        (void)create::array<int>(memory, {1, 2, 3});
+        commit(memory, *header);
+        committed = memory.size();
+
+        // Simulate a crash after appending but before committing
+        (void)create::array<int>(memory, {4, 5, 6});
+    }
+    linear_memory_resource<FlushRecordingAllocator> memory(file.size(),
+                                                          FlushRecordingAllocator{&file, &flushes});
+    commit_header*                                  header = recover(memory);
+    EXPECT_EQ(static_cast<void*>(header), memory.data());
+    EXPECT_EQ(memory.size(), committed);
+    std::span<int> ints(reinterpret_cast<int*>(file.data() + sizeof(commit_header)), 3);
+    EXPECT_THAT(ints, testing::ElementsAre(1, 2, 3));
+
+    // Allocation resumes after the committed data
+    EXPECT_EQ(memory.allocate(1, 1), file.data() + committed);
+}
+
+TEST(Commit, RecoverEmpty) {
+    std::vector<std::byte>                 file(1024);
+    std::vector<std::pair<size_t, size_t>> flushes;
+    linear_memory_resource<FlushRecordingAllocator> memory(file.size(),
+                                                          FlushRecordingAllocator{&file, &flushes});
+    commit_header*                                  header = recover(memory);
+    EXPECT_EQ(header->committedSize, 0);
+    EXPECT_EQ(memory.size(), sizeof(commit_header));
+}
+
+TEST(DirtyTracker, Software) {
+    // Page aligned so marks map to known pages
+    linear_memory_resource<virtual_memory_resource> memory(
+        page_size() * 4, virtual_memory_resource(page_size() * 4));
+    std::span<std::byte> bytes = create::array<std::byte>(memory, page_size() * 4);
+    dirty_tracker        tracker(memory, dirty_tracker::mode::software);
+    EXPECT_TRUE(tracker.enumerate_dirty().empty());
+
+    // Marks are rounded out to pages and coalesced. Page 2 stays clean.
+    tracker.mark_dirty(&bytes[1], 1);
+    tracker.mark_dirty(&bytes[page_size() + 1], 1);
+    tracker.mark_dirty(&bytes[page_size() * 4 - 1], 1);
+    EXPECT_THAT(tracker.enumerate_dirty(),
+                testing::ElementsAre(page_range{0, page_size() * 2},
+                                     page_range{page_size() * 3, page_size()}));
+
+    tracker.clear();
+    EXPECT_TRUE(tracker.enumerate_dirty().empty());
+}
+
+TEST(DirtyTracker, SoftDirty) {
+    if (!dirty_tracker::soft_dirty_supported())
+        GTEST_SKIP() << "Kernel does not support soft-dirty page tracking";
+    std::vector<std::byte> buffer(page_size() * 8);
+    std::byte*             pages = reinterpret_cast<std::byte*>(
+        align_up(reinterpret_cast<uintptr_t>(buffer.data()), page_size()));
+    dirty_tracker          tracker(pages, page_size() * 4, dirty_tracker::mode::soft_dirty);
+    pages[page_size() * 2 + 7] = std::byte{42};
+    EXPECT_THAT(tracker.enumerate_dirty(),
+                testing::Contains(page_range{page_size() * 2, page_size()}));
+}
+
+static_assert(realloc_memory_resource<virtual_memory_resource>);
+static_assert(has_max_size<virtual_memory_resource>);
+
+TEST(VirtualMemoryResource, GrowsInPlace) {
+    linear_memory_resource<virtual_memory_resource> memory(
+        virtual_memory_resource(page_size() * 64));
+    std::span<uint8_t> first = create::array<uint8_t>(memory, 100);
+    std::ranges::fill(first, 0xeeu);
+    void* base = memory.data();
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(base) % page_size(), 0);
+    (void)create::array<uint8_t>(memory, page_size() * 20);
+    EXPECT_EQ(memory.data(), base);
+    EXPECT_GE(memory.parent().committed(), page_size() * 20 + 100);
+    EXPECT_EQ(first[99], 0xeeu);
+
+    // Capacity doubling is clamped to the reservation
+    (void)create::array<uint8_t>(memory, page_size() * 21);
+    (void)create::array<uint8_t>(memory, page_size());
+    EXPECT_EQ(memory.capacity(), page_size() * 64);
+    EXPECT_EQ(memory.data(), base);
+    EXPECT_THROW((void)create::array<uint8_t>(memory, page_size() * 64), std::bad_alloc);
+}
+
+TEST(VirtualMemoryResource, FixedBaseTaken) {
+    virtual_memory_resource first(page_size());
+    EXPECT_THROW(virtual_memory_resource(page_size(), first.base()), std::bad_alloc);
+}
+
+TEST(VirtualMemoryResource, Decommit) {
+    virtual_memory_resource memory(page_size() * 4);
+    auto*                   bytes = static_cast<uint8_t*>(memory.allocate(page_size() * 3, 1));
+    std::fill_n(bytes, page_size() * 3, uint8_t(0xee));
+
+    // Only whole pages are released
+    memory.decommit(bytes + 1, page_size() * 2);
+    EXPECT_EQ(bytes[0], 0xeeu);
+    EXPECT_EQ(bytes[page_size()], 0u);
+    EXPECT_EQ(bytes[page_size() * 2 - 1], 0u);
+    EXPECT_EQ(bytes[page_size() * 2], 0xeeu);
+    memory.deallocate(bytes, page_size() * 3);
+}
+
+static_assert(has_try_expand<virtual_memory_resource>);
+static_assert(has_decommit<virtual_memory_resource>);
+static_assert(zero_filled<virtual_memory_resource>);
+static_assert(address_stable<virtual_memory_resource>);
+static_assert(page_aligned<virtual_memory_resource>);
+static_assert(!zero_filled<std::allocator<std::byte>>);
+static_assert(address_stable<linear_memory_resource<>>);
+static_assert(address_stable<linear_allocator<int>>);
+static_assert(!zero_filled<linear_allocator<int>>);
+
+// Grows in place only, without a reallocate()
+struct ExpandOnlyMemoryResource {
+    std::byte* buffer;
+    size_t     capacity;
+    size_t     size = 0;
+    void*      allocate(std::size_t bytes, std::size_t align) {
+        (void)align;
+        return try_expand(buffer, bytes) ? buffer : throw std::bad_alloc();
+    }
+    void deallocate(void* p, std::size_t bytes) {
+        (void)p;
+        (void)bytes;
+    }
+    bool try_expand(void* p, std::size_t bytes) {
+        EXPECT_EQ(p, buffer);
+        if (bytes > capacity)
+            return false;
+        size = std::max(size, bytes);
+        return true;
+    }
+};
+
+static_assert(!realloc_memory_resource<ExpandOnlyMemoryResource>);
+static_assert(growable_resource_or_allocator<ExpandOnlyMemoryResource>);
+
+TEST(Capabilities, TryExpandGrowth) {
+    alignas(16) std::byte                            buffer[256];
+    linear_memory_resource<ExpandOnlyMemoryResource> memory(
+        16, ExpandOnlyMemoryResource{buffer, sizeof(buffer)});
+    (void)create::array<uint8_t>(memory, 10);
+    (void)create::array<uint8_t>(memory, 100);
+    EXPECT_EQ(memory.data(), buffer);
+    EXPECT_EQ(memory.parent().size, memory.capacity());
+    EXPECT_GE(memory.capacity(), 110);
+    EXPECT_THROW((void)create::array<uint8_t>(memory, 200), std::bad_alloc);
+}
+
+// Claims zero filled memory but returns a pattern, to detect construction
+struct PatternMemoryResource {
+    static constexpr bool zero_filled = true;
+    std::byte             buffer[64];
+    void*                 allocate(std::size_t bytes, std::size_t align) {
+        (void)align;
+        std::memset(buffer, 0xab, bytes);
+        return buffer;
+    }
+    void deallocate(void* p, std::size_t bytes) {
+        (void)p;
+        (void)bytes;
+    }
+};
+
+struct NonTrivialInit {
+    uint8_t value = 1;
+};
+
+TEST(Capabilities, ZeroFilledSkipsConstruction) {
+    PatternMemoryResource memory;
+    EXPECT_EQ(create::array<uint8_t>(memory, 4)[3], 0xabu);
+    EXPECT_EQ(create::array<NonTrivialInit>(memory, 4)[3].value, 1u);
+
+    // Fresh pages of a virtual_memory_resource really are zero
+    virtual_memory_resource virtualMemory(page_size());
+    EXPECT_EQ(create::array<uint64_t>(virtualMemory, 8)[7], 0u);
+}
+
+static_assert(realloc_memory_resource<malloc_expand_parent>);
+static_assert(has_try_expand<malloc_expand_parent>);
+static_assert(address_stable<malloc_expand_parent>);
+
+TEST(MallocExpandParent, NeverMoves) {
+    malloc_expand_parent parent;
+    size_t               size = malloc_expand_parent::mremap_threshold;
+    auto*                bytes = static_cast<uint8_t*>(parent.allocate(size, 1));
+    std::fill_n(bytes, size, uint8_t(0xee));
+
+    // Growth may fail if the address space after the chunk is taken, but the
+    // allocation must never move
+    for (int i = 0; i < 4; ++i) {
+        void* result = parent.reallocate(bytes, size * 2, 1);
+        if (!result)
+            break;
+        EXPECT_EQ(result, bytes);
+        size *= 2;
+        EXPECT_EQ(bytes[size / 2 - 1], 0xeeu);
+        std::fill_n(bytes, size, uint8_t(0xee));
+    }
+
+    // Shrinking always succeeds in place
+    EXPECT_EQ(parent.reallocate(bytes, 100, 1), bytes);
+    EXPECT_EQ(bytes[99], 0xeeu);
+    parent.deallocate(bytes, 100);
+}
+
+TEST(MallocExpandParent, LinearGrowth) {
+    linear_memory_resource<malloc_expand_parent> memory(malloc_expand_parent::mremap_threshold,
+                                                        malloc_expand_parent());
+    void* base = memory.data();
+    (void)create::array<uint8_t>(memory, 100);
+    try {
+        (void)create::array<uint8_t>(memory, malloc_expand_parent::mremap_threshold * 3);
+        EXPECT_GE(memory.capacity(), malloc_expand_parent::mremap_threshold * 3 + 100);
+    } catch (const std::bad_alloc&) {
+        EXPECT_EQ(memory.capacity(), malloc_expand_parent::mremap_threshold);
+    }
+    EXPECT_EQ(memory.data(), base);
+    memory.truncate();
+    EXPECT_EQ(memory.capacity(), memory.size());
+}
+
+TEST(Freeze, ReadOnly) {
+    linear_memory_resource<virtual_memory_resource> memory(
+        virtual_memory_resource(page_size() * 4));
+    std::span<uint32_t> values = create::array<uint32_t>(memory, page_size() / 2);
+    std::ranges::fill(values, 7u);
+    freeze(memory, {.mergeable = true, .trapWrites = true});
+    EXPECT_EQ(values.back(), 7u);
+#if GTEST_HAS_DEATH_TEST
+    EXPECT_DEATH(values[3] = 8u, "write to frozen arena at 0x[0-9a-f]+, offset 0x0+c");
+#endif
+    thaw(memory);
+    values[3] = 8u;
+    EXPECT_EQ(values[3], 8u);
+}
+
+TEST(Scratch, Rewinds) {
+    size_t start = scratch().resource().size();
+    {
+        scratch_scope  temp = scratch();
+        std::span<int> values = create::array<int>(temp, 1000);
+        EXPECT_EQ(values.size(), 1000);
+        EXPECT_GE(temp.resource().size(), start + sizeof(int) * 1000);
+    }
+    EXPECT_EQ(scratch().resource().size(), start);
+}
+
+// Produces output in 'output' using temporaries from another scratch arena
+static std::span<int> squares(scratch_scope& output, int count) {
+    scratch_scope  temp = scratch(output);
+    std::span<int> values = create::array<int>(temp, static_cast<size_t>(count));
+    for (int i = 0; i < count; ++i)
+        values[i] = i * i;
+    return create::array<int>(output, values);
+}
+
+TEST(Scratch, ConflictFreeNesting) {
+    scratch_scope  outer = scratch();
+    std::span<int> result = squares(outer, 100);
+    EXPECT_EQ(result[99], 99 * 99);
+
+    scratch_scope inner = scratch(outer);
+    EXPECT_NE(&inner.resource(), &outer.resource());
+    scratch_scope innermost = scratch(inner);
+    EXPECT_EQ(&innermost.resource(), &outer.resource());
+
+    linear_memory_resource<> unrelated(16);
+    EXPECT_EQ(&scratch(unrelated).resource(), &outer.resource());
+}
+
+TEST_F(Allocate, Rewind) {
+    linear_memory_resource memory(100);
+    (void)create::array<uint8_t>(memory, 10);
+    size_t marker = memory.size();
+    (void)create::array<uint8_t>(memory, 20);
+    memory.rewind(marker);
+    EXPECT_EQ(memory.size(), 10);
+}
+
+TEST(Decommit, ResetVirtualMemory) {
+    linear_memory_resource<virtual_memory_resource> memory(
+        virtual_memory_resource(page_size() * 4));
+    std::ranges::fill(create::array<uint8_t>(memory, page_size() * 2), 0xeeu);
+    memory.reset_decommit();
+    EXPECT_EQ(memory.size(), 0);
+    EXPECT_EQ(create::array<uint8_t>(memory, page_size() * 2)[page_size()], 0u);
+}
+
+#if defined(__linux__)
+// Shared file mapping parent that punches holes on decommit()
+struct MappedFileMemoryResource {
+    int   fd;
+    void* mapping = nullptr;
+    void* allocate(std::size_t bytes, std::size_t align) {
+        (void)align;
+        EXPECT_EQ(ftruncate(fd, static_cast<off_t>(bytes)), 0);
+        mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        EXPECT_NE(mapping, MAP_FAILED);
+        return mapping;
+    }
+    void deallocate(void* p, std::size_t bytes) { munmap(p, bytes); }
+    void decommit(void* p, std::size_t bytes) {
+        uintptr_t offset = reinterpret_cast<uintptr_t>(p) - reinterpret_cast<uintptr_t>(mapping);
+        uintptr_t begin = align_up(offset, page_size());
+        uintptr_t end = align_down(offset + bytes, page_size());
+        if (begin < end)
+            (void)punch_hole(fd, begin, end - begin);
+    }
+};
+
+static_assert(has_decommit<MappedFileMemoryResource>);
+
+TEST(Decommit, PunchHole) {
+    std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "decodeless_punch_hole_test.bin";
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    ASSERT_GE(fd, 0);
+    size_t size = page_size() * 16;
+    {
+        linear_memory_resource<MappedFileMemoryResource> memory(size,
+                                                                MappedFileMemoryResource{fd});
+        std::ranges::fill(create::array<uint8_t>(memory, size), 0xeeu);
+        EXPECT_EQ(msync(memory.data(), size, MS_SYNC), 0);
+        struct stat before;
+        ASSERT_EQ(fstat(fd, &before), 0);
+        memory.reset_decommit();
+        struct stat after;
+        ASSERT_EQ(fstat(fd, &after), 0);
+        EXPECT_EQ(after.st_size, before.st_size);
+        if (after.st_blocks == before.st_blocks) {
+            close(fd);
+            std::filesystem::remove(path);
+            GTEST_SKIP() << "file system does not support punching holes";
+        }
+        EXPECT_LT(after.st_blocks, before.st_blocks);
+        EXPECT_EQ(create::array<uint8_t>(memory, size)[size - 1], 0u);
+    }
+    close(fd);
+    std::filesystem::remove(path);
+}
+#endif
+
+#if !defined(_WIN32)
+TEST(StripedFileResource, WriteRead) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path();
+    std::vector<std::filesystem::path> files{dir / "decodeless_stripe0.bin",
+                                             dir / "decodeless_stripe1.bin",
+                                             dir / "decodeless_stripe2.bin"};
+    size_t stripeSize = page_size() * 2;
+    size_t count = stripeSize * 7 / sizeof(uint32_t) + 5;
+    {
+        striped_linear_resource memory(striped_file_resource(files, stripeSize, stripeSize * 16));
+        std::span<uint32_t>     values = create::array<uint32_t>(memory, count);
+        for (size_t i = 0; i < count; ++i)
+            values[i] = static_cast<uint32_t>(i * 2654435761u);
+        EXPECT_EQ(memory.data(), memory.parent().base());
+        EXPECT_EQ(memory.parent().stripe_count(), 8);
+        memory.parent().flush(static_cast<std::byte*>(memory.data()), memory.size());
+        EXPECT_THROW((void)create::array<uint8_t>(memory, stripeSize * 16), std::bad_alloc);
+    }
+
+    // Eight stripes round robin over three files
+    EXPECT_EQ(std::filesystem::file_size(files[0]), stripeSize * 3);
+    EXPECT_EQ(std::filesystem::file_size(files[1]), stripeSize * 3);
+    EXPECT_EQ(std::filesystem::file_size(files[2]), stripeSize * 2);
+    {
+        striped_file_reader reader(files, stripeSize);
+        EXPECT_EQ(reader.data().size(), stripeSize * 8);
+        auto* values = reinterpret_cast<const uint32_t*>(reader.data().data());
+        for (size_t i = 0; i < count; ++i)
+            ASSERT_EQ(values[i], static_cast<uint32_t>(i * 2654435761u)) << i;
+    }
+    std::filesystem::resize_file(files[2], stripeSize * 4);
+    EXPECT_THROW(striped_file_reader(files, stripeSize), std::runtime_error);
+    for (const std::filesystem::path& file : files)
+        std::filesystem::remove(file);
+}
+
+TEST(StripedFileResource, OddStripeDecommit) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path();
+    std::vector<std::filesystem::path> files{dir / "decodeless_odd_stripe0.bin",
+                                             dir / "decodeless_odd_stripe1.bin"};
+
+    // Not a power of two, and the reservation must still round up to cover it
+    size_t stripeSize = page_size() * 3;
+    size_t reserveSize = stripeSize * 4 + 1;
+    {
+        striped_file_resource resource(files, stripeSize, reserveSize);
+        EXPECT_GE(resource.max_size(), reserveSize);
+        EXPECT_EQ(resource.max_size() % stripeSize, 0);
+        striped_linear_resource memory(std::move(resource));
+        std::span<uint8_t>      bytes = create::array<uint8_t>(memory, reserveSize);
+        std::ranges::fill(bytes, uint8_t(7));
+        EXPECT_EQ(memory.parent().stripe_count(), 5);
+
+        // A range straddling stripes 1 and 2, which live in different files
+        std::byte* begin = static_cast<std::byte*>(memory.data()) + stripeSize + page_size();
+        memory.parent().decommit(begin, stripeSize);
+        EXPECT_EQ(bytes[stripeSize + page_size() - 1], 7);
+        EXPECT_EQ(bytes[stripeSize + page_size()], 0);
+        EXPECT_EQ(bytes[stripeSize * 2 + page_size() - 1], 0);
+        EXPECT_EQ(bytes[stripeSize * 2 + page_size()], 7);
+
+        memory.reset_decommit();
+        EXPECT_EQ(bytes[0], 0);
+        EXPECT_EQ(bytes[stripeSize * 4 - 1], 0);
+        EXPECT_EQ(bytes[reserveSize - 1], 7); // partial last page is kept
+        EXPECT_EQ(memory.size(), 0);
+    }
+    for (const std::filesystem::path& file : files)
+        std::filesystem::remove(file);
+}
+#endif
+
+TEST(PlacementBatch, NoPadding) {
+    linear_memory_resource                    memory(1000);
+    placement_batch<linear_memory_resource<>> batch(memory);
+    batch_array<char>                         name = batch.array<char>(3);
+    batch_object<double>                      weight = batch.object<double>(2.5);
+    std::vector<int>                          source{1, 2, 3};
+    batch_array<int>                          ints = batch.array<int>(source);
+    batch_object<char>                        flag = batch.object<char>('x');
+    batch_object<int2>                        pair = batch.object<int2>(4, 5);
+    batch.place();
+
+    // Placed in request order this would need 40 bytes including padding
+    EXPECT_EQ(memory.size(), 3 + 8 + 12 + 1 + 8);
+    EXPECT_EQ(batch.get(name).size(), 3);
+    EXPECT_EQ(batch.get(name)[0], '\0');
+    EXPECT_EQ(*batch.get(weight), 2.5);
+    EXPECT_THAT(batch.get(ints), testing::ElementsAre(1, 2, 3));
+    EXPECT_EQ(*batch.get(flag), 'x');
+    EXPECT_EQ(batch.get(pair)->y, 5);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(batch.get(weight)) % alignof(double), 0);
+    EXPECT_EQ(static_cast<void*>(batch.get(weight)), memory.data());
+}
+
+TEST(ArenaHandle, RoundTrip) {
+    linear_memory_resource memory(1000);
+    (void)create::object<char>(memory, 'a');
+    int*                   value = create::object<int>(memory, 42);
+    std::span<double>      values = create::array<double>(memory, {1.0, 2.0, 3.0});
+    arena_handle<int, 2>   handle(memory.data(), value);
+    arena_span32<double>   span(memory.data(), values);
+    static_assert(sizeof(handle) == 4);
+    static_assert(sizeof(span) == 8);
+    EXPECT_EQ(handle.offset(), 4);
+    EXPECT_EQ(handle.raw(), 1);
+    EXPECT_EQ(handle.get(memory.data()), value);
+    EXPECT_EQ(span.get(memory.data()).data(), values.data());
+    EXPECT_THAT(span.get(memory.data()), testing::ElementsAre(1.0, 2.0, 3.0));
+
+    // Resolves against a copy of the arena at another address
+    std::vector<std::byte> copy(static_cast<std::byte*>(memory.data()),
+                                static_cast<std::byte*>(memory.data()) + memory.size());
+    const void*            copyBase = copy.data();
+    EXPECT_EQ(*handle.get(copyBase), 42);
+    EXPECT_THAT(span.get(copyBase), testing::ElementsAre(1.0, 2.0, 3.0));
+
+    arena_handle<int> null(memory.data(), nullptr);
+    EXPECT_FALSE(null);
+    EXPECT_EQ(null, arena_handle<int>());
+    EXPECT_EQ(null.get(memory.data()), nullptr);
+}
+
+TEST(ArenaHandle, Overflow) {
+    // Addresses only, never dereferenced
+    auto* base = reinterpret_cast<std::byte*>(uintptr_t(1) << 20);
+    auto* near = reinterpret_cast<const int*>(base + 8);
+    auto* far = reinterpret_cast<const int*>(base + (uint64_t(5) << 30));
+    EXPECT_THROW((arena_handle<int, 0>(base, far)), std::overflow_error);
+    EXPECT_EQ((arena_handle<int, 2>(base, far).offset()), uint64_t(5) << 30);
+    EXPECT_THROW((arena_handle<int, 4>(base, near)), std::overflow_error);
+    EXPECT_THROW((arena_handle<int>(base + 16, near)), std::overflow_error);
+}
+
+TEST(CacheColoring, DistinctColors) {
+    // 64 KiB arrays start at the same offset modulo 4 KiB when back to back
+    linear_memory_resource<virtual_memory_resource> memory(
+        virtual_memory_resource(size_t(4) << 20));
+    cache_colored_resource colored(memory);
+    size_t                 period = colored.options().colors * colored.options().step;
+    std::vector<uintptr_t> colors;
+    for (size_t i = 0; i < 18; ++i) {
+        std::span<float> array = create::array<float>(colored, 16384);
+        colors.push_back(reinterpret_cast<uintptr_t>(array.data()) % period);
+        (void)create::object<int>(colored, 1); // small, not colored
+    }
+    for (size_t i = 0; i < colors.size(); ++i)
+        EXPECT_EQ(colors[i], (i % colored.options().colors) * colored.options().step) << i;
+
+    // Any 'colors' consecutive arrays are distinct modulo the period
+    std::vector<uintptr_t> first(colors.begin(), colors.begin() + 16);
+    std::ranges::sort(first);
+    EXPECT_EQ(std::ranges::adjacent_find(first), first.end());
+
+    // Padding is bounded by one period per array
+    EXPECT_LT(memory.size(), 18 * (16384 * sizeof(float) + sizeof(int) + period));
+}
+
+TEST(ObjectCompact, NoStraddle) {
+    struct Header {
+        uint32_t key[3];
+        uint32_t value;
+    };
+    // Page aligned so offsets match cache line boundaries
+    linear_memory_resource<virtual_memory_resource> memory(virtual_memory_resource(4096));
+    auto offset = [&](const void* p) {
+        return static_cast<const std::byte*>(p) - static_cast<const std::byte*>(memory.data());
+    };
+    (void)create::array<char>(memory, 60);
+    EXPECT_EQ(offset(create::object_compact<Header>(memory)), 64);
+    (void)create::array<char>(memory, 1);
+    EXPECT_EQ(offset(create::object_compact<Header>(memory, Header{{1, 2, 3}, 4})), 84);
+    EXPECT_EQ(offset(create::object_compact<Header>(memory)), 100);
+    EXPECT_EQ(offset(create::object_compact<Header>(memory)), 128);
+
+    // Resources without allocate_no_straddle() over-align instead
+    scratch_scope temp = scratch();
+    (void)create::array<char>(temp, 1);
+    Header* header = create::object_compact<Header>(temp);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(header) % sizeof(Header), 0);
+}
+
+TEST(LargeObjects, BypassArena) {
+    large_object_linear_resource<virtual_memory_resource> memory(
+        linear_memory_resource(virtual_memory_resource(size_t(1) << 30)), 1 << 20);
+    (void)create::array<int>(memory, 1000);
+    (void)create::object<int>(memory, 42);
+    size_t            capacity = memory.arena().capacity();
+    std::span<double> huge = create::array<double>(memory, 1 << 20);
+    huge.back() = 1.0;
+    EXPECT_EQ(memory.arena().capacity(), capacity);
+    EXPECT_EQ(memory.size(), 1000 * sizeof(int) + sizeof(int));
+    EXPECT_EQ(memory.large_size(), (1 << 20) * sizeof(double));
+    EXPECT_EQ(memory.large_count(), 1);
+    EXPECT_FALSE(huge.data() >= memory.arena().data() &&
+                 huge.data() < static_cast<double*>(memory.arena().data()) + capacity);
+    memory.reset();
+    EXPECT_EQ(memory.size(), 0);
+    EXPECT_EQ(memory.large_size(), 0);
+    EXPECT_EQ(memory.large_count(), 0);
+}
+
+TEST(DoubleEnded, FrontAndBack) {
+    double_ended_linear_resource memory(64);
+    std::span<int>               output = create::array<int>(memory, {1, 2, 3});
+    auto                         back = memory.back();
+    std::span<double>            temp = create::array<double>(back, {4.0, 5.0});
+    EXPECT_EQ(memory.size(), 3 * sizeof(int));
+    EXPECT_EQ(memory.back_size(), 2 * sizeof(double));
+    EXPECT_EQ(static_cast<void*>(output.data()), memory.data());
+    EXPECT_EQ(reinterpret_cast<std::byte*>(temp.data() + 2),
+              static_cast<std::byte*>(memory.data()) + memory.capacity());
+    memory.reset_back();
+    EXPECT_EQ(memory.back_size(), 0);
+    EXPECT_THAT(output, testing::ElementsAre(1, 2, 3));
+}
+
+TEST(DoubleEnded, GrowMovesBack) {
+    double_ended_linear_resource<virtual_memory_resource> memory(
+        4096, virtual_memory_resource(size_t(1) << 20));
+    std::span<int>    output = create::array<int>(memory, {1, 2, 3});
+    auto              back = memory.back();
+    std::span<double> temp = create::array<double>(back, {4.0, 5.0});
+    (void)temp;
+
+    // Meeting in the middle grows the allocation and moves the back region
+    (void)create::array<char>(memory, 4096);
+    EXPECT_EQ(memory.capacity(), 8192);
+    EXPECT_EQ(memory.back_size(), 2 * sizeof(double));
+    auto* moved = reinterpret_cast<double*>(static_cast<std::byte*>(memory.data()) +
+                                            memory.capacity() - memory.back_size());
+    EXPECT_EQ(moved[0], 4.0);
+    EXPECT_EQ(moved[1], 5.0);
+    EXPECT_THAT(output, testing::ElementsAre(1, 2, 3));
+
+    (void)create::array<double>(back, 1000);
+    EXPECT_GE(memory.capacity(), 8192 + 8000);
+    memory.truncate();
+    EXPECT_EQ(memory.back_size(), 0);
+    EXPECT_EQ(memory.capacity(), memory.size());
+    EXPECT_THAT(output, testing::ElementsAre(1, 2, 3));
+}
+
+TEST(AllocateParallel, DeterministicLayout) {
+    std::vector<size_t> sizes;
+    for (size_t i = 0; i < 1000; ++i)
+        sizes.push_back((i * 37) % 101);
+    linear_memory_resource memory(1 << 20);
+    (void)create::object<char>(memory, 'x');
+    std::vector<void*> serial = allocate_parallel(memory, sizes, 8, 1);
+    std::vector<void*> parallel = allocate_parallel(memory, sizes, 8, 7);
+    ASSERT_EQ(parallel.size(), sizes.size());
+    auto*  base = static_cast<std::byte*>(serial[0]);
+    auto*  parallelBase = static_cast<std::byte*>(parallel[0]);
+    size_t offset = 0;
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        EXPECT_EQ(static_cast<std::byte*>(serial[i]), base + offset);
+        EXPECT_EQ(static_cast<std::byte*>(parallel[i]), parallelBase + offset);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(parallel[i]) % 8, 0);
+        offset += (sizes[i] + 7) / 8 * 8;
+    }
+    EXPECT_EQ(parallelBase, base + offset);
+    EXPECT_TRUE(allocate_parallel(memory, std::span<const size_t>(), 8).empty());
+}
+
+TEST(ArenaFormat, OutputIterator) {
+    static_assert(std::output_iterator<arena_output_iterator<std::allocator<std::byte>>, char>);
+    linear_memory_resource<virtual_memory_resource> memory(virtual_memory_resource(1 << 20));
+    (void)create::object<int>(memory, 1);
+    std::string      text(10000, 'a');
+    std::string_view result = std::copy(text.begin(), text.end(), arena_output_iterator(memory))
+                                  .view();
+    EXPECT_EQ(result, text);
+    EXPECT_EQ(result.data(), static_cast<char*>(memory.data()) + sizeof(int));
+    EXPECT_EQ(memory.size(), sizeof(int) + text.size());
+
+    // The usual output iterator idiom writes through temporary copies
+    arena_output_iterator it(memory);
+    for (char c : std::string_view("hello"))
+        *it++ = c;
+    std::string_view hello = it.view();
+    EXPECT_EQ(hello, "hello");
+    EXPECT_EQ(hello.data(), result.data() + result.size());
+
+#ifdef __cpp_lib_format
+    std::string_view formatted = arena_format_to(memory, "{} + {} = {}", 1, 2, 1 + 2);
+    EXPECT_EQ(formatted, "1 + 2 = 3");
+    EXPECT_EQ(formatted.data(), hello.data() + hello.size());
+#endif
+}
+
+struct PersistentNode {
+    int             value;
+    PersistentNode* next;
+};
+
+TEST(PersistentArena, SaveLoad) {
+    std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "decodeless_persistent_arena_test.bin";
+    void* base;
+    {
+        persistent_arena arena(page_size() * 16);
+        base = arena.base();
+        PersistentNode* tail = create::object<PersistentNode>(arena.memory(), 2, nullptr);
+        (void)create::object<PersistentNode>(arena.memory(), 1, tail);
+        arena.save(path);
+    }
+
+    // The original address is free again so raw pointers remain valid
+    {
+        persistent_arena arena = persistent_arena::load(path);
+        EXPECT_EQ(arena.base(), base);
+        EXPECT_EQ(arena.relocation(), 0);
+        EXPECT_EQ(arena.memory().size(), sizeof(PersistentNode) * 2);
+        auto* head = reinterpret_cast<PersistentNode*>(
+            static_cast<std::byte*>(arena.memory().data()) + sizeof(PersistentNode));
+        EXPECT_EQ(head->value, 1);
+        EXPECT_EQ(head->next->value, 2);
+
+        // Loading again while the address is taken falls back to relocation
+        persistent_arena relocated = persistent_arena::load(path);
+        EXPECT_NE(relocated.base(), base);
+        EXPECT_NE(relocated.relocation(), 0);
+        auto* relocatedHead = reinterpret_cast<PersistentNode*>(
+            static_cast<std::byte*>(relocated.memory().data()) + sizeof(PersistentNode));
+        EXPECT_EQ(relocated.relocate(relocatedHead->next)->value, 2);
+        EXPECT_EQ(relocated.relocate(relocatedHead->next)->next, nullptr);
+
+        // Allocation continues after the loaded image
+        (void)create::object<int>(relocated.memory(), 3);
+        EXPECT_GT(relocated.memory().size(), sizeof(PersistentNode) * 2);
+    }
+    std::filesystem::remove(path);
+}
+
+DECODELESS_EMBEDDED_ARENA(test_table);
+
+TEST(EmbeddedArena, Access) {
+    std::span<const std::byte> image = decodeless_embedded_arena_test_table();
+    EXPECT_EQ(image.size(), sizeof(arena_image_header) + sizeof(EmbeddedTable));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(image.data()) % 64, 0);
+    const EmbeddedTable& table = embedded_object<EmbeddedTable>(image);
+    EXPECT_EQ(table.count, 15);
+    EXPECT_EQ(table.squares[14], 14 * 14);
+}
+
+TEST(EmbeddedArena, ForeignByteOrder) {
+    std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "decodeless_arena_image_test.bin";
+    {
+        linear_memory_resource memory(1024);
+        std::span<uint32_t>    values = create::array<uint32_t>(memory, 4);
+        for (uint32_t i = 0; i < values.size(); ++i)
+            values[i] = 0x01020300 + i;
+        write_arena_image(memory, path);
+    }
+    std::vector<std::byte> image(std::filesystem::file_size(path));
+    std::ifstream(path, std::ios::binary)
+        .read(reinterpret_cast<char*>(image.data()), static_cast<std::streamsize>(image.size()));
+    std::filesystem::remove(path);
+    EXPECT_EQ(arena_image_data(image).size(), 4 * sizeof(uint32_t));
+
+    // Rewrite the image as if from a machine with the opposite byte order
+    arena_image_header header;
+    std::memcpy(&header, image.data(), sizeof(header));
+    header.abi.bigEndian = !header.abi.bigEndian;
+    byteswap_inplace(std::span(&header.size, 1));
+    std::memcpy(image.data(), &header, sizeof(header));
+    byteswap_inplace(std::span(reinterpret_cast<uint32_t*>(image.data() + sizeof(header)), 4));
+    EXPECT_THROW((void)arena_image_data(image), std::runtime_error);
+
+    linear_memory_resource memory(1024);
+    int                    swaps = 0;
+    std::span<std::byte>   payload = load_arena_image(memory, image, [&](std::span<std::byte> p) {
+        byteswap_inplace(std::span(reinterpret_cast<uint32_t*>(p.data()), p.size() / 4));
+        ++swaps;
+    });
+    EXPECT_EQ(swaps, 1);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(payload.data()) % 64, 0);
+    EXPECT_THAT(std::span(reinterpret_cast<const uint32_t*>(payload.data()), 4),
+                testing::ElementsAre(0x01020300, 0x01020301, 0x01020302, 0x01020303));
+
+    // Sizes and alignment cannot be converted
+    header.abi.pointerSize = header.abi.pointerSize == 8 ? 4 : 8;
+    std::memcpy(image.data(), &header, sizeof(header));
+    EXPECT_THROW((void)load_arena_image(memory, image, [](std::span<std::byte>) {}),
+                 std::runtime_error);
+}
+
+TEST(Parallel, ChunksCoverRange) {
+    for (size_t threads : {0, 1, 3, 8}) {
+        std::vector<std::atomic<int>> visits(1000);
+        parallel_for_chunks(
+            visits.size(), threads,
+            [&visits](size_t begin, size_t end) {
+                EXPECT_EQ(begin % 16, 0);
+                for (size_t i = begin; i < end; ++i)
+                    ++visits[i];
+            },
+            16);
+        EXPECT_TRUE(std::ranges::all_of(visits, [](const std::atomic<int>& v) { return v == 1; }));
+    }
+}
+
+TEST(Prefetch, Arena) {
+    linear_memory_resource<virtual_memory_resource> memory(
+        virtual_memory_resource(page_size() * 64));
+    // Allocated without construction so pages are only touched by prefetching
+    size_t             pages = 34;
+    size_t             size = page_size() * (pages - 1) + 5;
+    std::span<uint8_t> bytes(static_cast<uint8_t*>(memory.allocate(size, 1)), size);
+#if defined(__linux__)
+    auto residentPages = [&] {
+        std::vector<unsigned char> resident(pages);
+        EXPECT_EQ(mincore(bytes.data(), bytes.size(), resident.data()), 0);
+        return std::ranges::count_if(resident, [](unsigned char r) { return r & 1; });
+    };
+    EXPECT_EQ(residentPages(), 0);
+#endif
+    prefetch_in_parallel(std::as_bytes(bytes), 4);
+#if defined(__linux__)
+    EXPECT_EQ(residentPages(), pages);
+#endif
+    prefetch_in_parallel(std::as_bytes(bytes.subspan(3, 100)), 4, true);
+    prefetch_in_parallel(std::as_bytes(std::span(bytes.data(), 0)));
+    EXPECT_EQ(bytes.back(), 0);
+}
+
+TEST(Prefetch, HugePageChunks) {
+    // A view starting partway into a huge page and crossing several of them
+    size_t                  hugePage = size_t(2) << 20;
+    virtual_memory_resource memory(hugePage * 6);
+    auto*                   base = static_cast<std::byte*>(memory.allocate(hugePage * 6, 1));
+    std::byte* begin = reinterpret_cast<std::byte*>(
+        align_up(reinterpret_cast<uintptr_t>(base), hugePage) + hugePage - page_size() * 3);
+    std::span<const std::byte> view(begin, hugePage * 3);
+    prefetch_in_parallel(view, 4, true);
+#if defined(__linux__)
+    std::vector<unsigned char> resident(view.size() / page_size());
+    EXPECT_EQ(mincore(const_cast<std::byte*>(view.data()), view.size(), resident.data()), 0);
+    EXPECT_TRUE(std::ranges::all_of(resident, [](unsigned char r) { return r & 1; }));
+#endif
+}
+
+template <class T>
+T reference_byteswap(T value) {
+    auto bytes = std::bit_cast<std::array<std::byte, sizeof(T)>>(value);
+    std::ranges::reverse(bytes);
+    return std::bit_cast<T>(bytes);
+}
+
+TEST(Byteswap, Scalars) {
+    std::vector<uint16_t> u16(37);
+    std::vector<uint32_t> u32(37);
+    std::vector<uint64_t> u64(37);
+    for (size_t i = 0; i < 37; ++i) {
+        u16[i] = static_cast<uint16_t>(0x0102 * (i + 1));
+        u32[i] = static_cast<uint32_t>(0x01020304u * (i + 1));
+        u64[i] = 0x0102030405060708ull * (i + 1);
+    }
+    auto e16 = u16;
+    auto e32 = u32;
+    auto e64 = u64;
+    std::ranges::transform(e16, e16.begin(), reference_byteswap<uint16_t>);
+    std::ranges::transform(e32, e32.begin(), reference_byteswap<uint32_t>);
+    std::ranges::transform(e64, e64.begin(), reference_byteswap<uint64_t>);
+    byteswap_inplace(std::span(u16));
+    byteswap_inplace(std::span(u32));
+    byteswap_inplace(std::span(u64));
+    EXPECT_EQ(u16, e16);
+    EXPECT_EQ(u32, e32);
+    EXPECT_EQ(u64, e64);
+}
+
+struct SwapRecord16 {
+    uint32_t a;
+    uint16_t b;
+    uint8_t  c[2];
+    uint64_t d;
+};
+
+struct SwapRecord12 {
+    uint32_t a[2];
+    uint16_t b;
+    uint16_t c;
+};
+
+TEST(Byteswap, Records) {
+    // Stride divides 16 bytes, converted with SIMD shuffles where available
+    std::vector<SwapRecord16> records(9);
+    for (uint32_t i = 0; i < records.size(); ++i)
+        records[i] = {0x01020304u + i, uint16_t(0x0506 + i), {7, 8}, 0x090a0b0c0d0e0f10ull + i};
+    field_descriptor fields16[] = {{offsetof(SwapRecord16, a), sizeof(SwapRecord16::a)},
+                                   {offsetof(SwapRecord16, b), sizeof(SwapRecord16::b)},
+                                   {offsetof(SwapRecord16, d), sizeof(SwapRecord16::d)}};
+    std::vector<SwapRecord16> swapped(records.size());
+    byteswap_records(records.data(), swapped.data(), records.size(), sizeof(SwapRecord16),
+                     fields16);
+    for (size_t i = 0; i < records.size(); ++i) {
+        EXPECT_EQ(swapped[i].a, reference_byteswap(records[i].a));
+        EXPECT_EQ(swapped[i].b, reference_byteswap(records[i].b));
+        EXPECT_EQ(swapped[i].c[0], 7);
+        EXPECT_EQ(swapped[i].c[1], 8);
+        EXPECT_EQ(swapped[i].d, reference_byteswap(records[i].d));
+    }
+
+    // Odd strides and field arrays, converted in place
+    std::vector<SwapRecord12> odd(5);
+    for (uint32_t i = 0; i < odd.size(); ++i)
+        odd[i] = {{0x01020304u + i, 0x05060708u + i}, uint16_t(0x090a + i), uint16_t(0x0b0c + i)};
+    auto             original = odd;
+    field_descriptor fields12[] = {{offsetof(SwapRecord12, a), sizeof(uint32_t), 2},
+                                   {offsetof(SwapRecord12, c), sizeof(SwapRecord12::c)}};
+    byteswap_records(odd.data(), odd.size(), sizeof(SwapRecord12), fields12);
+    for (size_t i = 0; i < odd.size(); ++i) {
+        EXPECT_EQ(odd[i].a[0], reference_byteswap(original[i].a[0]));
+        EXPECT_EQ(odd[i].a[1], reference_byteswap(original[i].a[1]));
+        EXPECT_EQ(odd[i].b, original[i].b);
+        EXPECT_EQ(odd[i].c, reference_byteswap(original[i].c));
+    }
+}
+
+TEST(Byteswap, InvalidRecords) {
+    std::vector<std::byte> data(1024);
+    field_descriptor       first{0, 4};
+    EXPECT_THROW(byteswap_records(data.data(), 4, 0, std::span(&first, 1)),
+                 std::invalid_argument);
+    field_descriptor outside{6, 4};
+    EXPECT_THROW(byteswap_records(data.data(), 4, 8, std::span(&outside, 1)),
+                 std::invalid_argument);
+
+    // count * size wraps around to 4
+    field_descriptor wrapping{0, 8, (SIZE_MAX >> 3) + 2};
+    EXPECT_THROW(byteswap_records(data.data(), 4, 8, std::span(&wrapping, 1)),
+                 std::invalid_argument);
+
+    // Strides larger than 256 bytes are supported
+    field_descriptor last{296, 4};
+    data[296] = std::byte(1);
+    data[300 + 299] = std::byte(2);
+    byteswap_records(data.data(), 2, 300, std::span(&last, 1));
+    EXPECT_EQ(data[299], std::byte(1));
+    EXPECT_EQ(data[300 + 296], std::byte(2));
+}
+
+TEST(Byteswap, ImageAbi) {
+    image_abi host = image_abi::host();
+    image_abi foreign = host;
+    foreign.bigEndian = !host.bigEndian;
+    EXPECT_NE(host, foreign);
+    EXPECT_TRUE(host.byteswap_compatible(foreign));
+    foreign.pointerSize = host.pointerSize == 8 ? 4 : 8;
+    EXPECT_FALSE(host.byteswap_compatible(foreign));
+}
+
+TEST(PackedArray, RandomAccess) {
+    std::vector<uint32_t> values(1000);
+    for (uint32_t i = 0; i < values.size(); ++i)
+        values[i] = 1'000'000 + (i * 7919) % 3000;
+    linear_memory_resource      memory(100000);
+    packed_array_view<uint32_t> packed = create::packed_array(memory, values);
+    EXPECT_EQ(packed.size(), values.size());
+    EXPECT_EQ(packed.base(), 1'000'000);
+    EXPECT_EQ(packed.bits(), 12);
+    EXPECT_LT(memory.size(), values.size() * sizeof(uint32_t) / 2);
+    for (size_t i = 0; i < values.size(); ++i)
+        ASSERT_EQ(packed[i], values[i]) << i;
+}
+
+TEST(PackedArray, DecodeBlocks) {
+    std::vector<uint64_t> values(300);
+    for (uint64_t i = 0; i < values.size(); ++i)
+        values[i] = i * 0x0123456789ull;
+    linear_memory_resource      memory(100000);
+    packed_array_view<uint64_t> packed = create::packed_array(memory, values);
+    std::vector<uint64_t>       decoded(values.size());
+    packed.decode(decoded);
+    EXPECT_EQ(decoded, values);
+
+    // Explicit widths, including the full width of T
+    for (unsigned bits : {packed.bits() + 3, 64u}) {
+        packed_array_view<uint64_t> wide = create::packed_array(memory, values, bits);
+        EXPECT_EQ(wide.bits(), bits);
+        std::ranges::fill(decoded, 0);
+        wide.decode(decoded);
+        EXPECT_EQ(decoded, values);
+    }
+}
+
+TEST(PackedArray, Constant) {
+    // Sized exactly so reads past the allocation are caught by sanitizers
+    std::vector<uint8_t>       values(200, 42);
+    linear_memory_resource     memory(packed_array_view<uint8_t>::allocation_size(200, 0));
+    packed_array_view<uint8_t> packed = create::packed_array(memory, values);
+    EXPECT_EQ(memory.size(), memory.capacity());
+    EXPECT_EQ(packed.bits(), 0);
+    EXPECT_EQ(packed[199], 42);
+    std::vector<uint8_t> decoded(values.size());
+    packed.decode(decoded);
+    EXPECT_EQ(decoded, values);
+
+    linear_memory_resource emptyMemory(packed_array_view<uint8_t>::allocation_size(0, 0));
+    EXPECT_EQ(create::packed_array(emptyMemory, std::vector<uint8_t>{}).size(), 0);
+}
+
+TEST(PackedArray, ExactSize) {
+    for (unsigned bits : {1u, 7u, 16u}) {
+        std::vector<uint16_t> values(300);
+        for (size_t i = 0; i < values.size(); ++i)
+            values[i] = static_cast<uint16_t>((i * 40503) & ((1u << bits) - 1));
+        linear_memory_resource memory(packed_array_view<uint16_t>::allocation_size(300, bits));
+        packed_array_view<uint16_t> packed = create::packed_array(memory, values, bits);
+        EXPECT_EQ(memory.size(), memory.capacity());
+        std::vector<uint16_t> decoded(values.size());
+        packed.decode(decoded);
+        EXPECT_EQ(decoded, values) << bits;
+        for (size_t i = 0; i < values.size(); ++i)
+            ASSERT_EQ(packed[i], values[i]) << bits << " " << i;
+    }
+}
+
+TEST(PackedArray, Reopen) {
+    std::vector<uint32_t> values{7, 100, 3, 55, 9};
+    linear_memory_resource      memory(1000);
+    packed_array_view<uint32_t> packed = create::packed_array(memory, values);
+    size_t offset = reinterpret_cast<const std::byte*>(packed.header()) -
+                    static_cast<const std::byte*>(memory.data());
+
+    // Copy to another address as if mapped from a file
+    std::vector<uint64_t> image(memory.size() / sizeof(uint64_t));
+    std::memcpy(image.data(), memory.data(), memory.size());
+    auto* header = reinterpret_cast<const packed_array_header*>(
+        reinterpret_cast<const std::byte*>(image.data()) + offset);
+    packed_array_view<uint32_t> reopened(header);
+    EXPECT_EQ(reopened.size(), values.size());
+    EXPECT_EQ(reopened.base(), 3);
+    for (size_t i = 0; i < values.size(); ++i)
+        EXPECT_EQ(reopened[i], values[i]);
+    EXPECT_THROW(packed_array_view<uint64_t>{header}, std::runtime_error);
+}
+
+TEST(PackedArray, Allocator) {
+    linear_memory_resource      memory(1000);
+    linear_allocator<std::byte> allocator(memory);
+    packed_array_view<uint16_t> packed =
+        create::packed_array<uint16_t>(allocator, std::vector<int>{5, 3, 9}, 8);
+    EXPECT_EQ(packed.bits(), 8);
+    EXPECT_EQ(packed[0], 5);
+    EXPECT_EQ(packed[1], 3);
+    EXPECT_EQ(packed[2], 9);
+}
+
+TEST(CsrGraph, Build) {
+    std::vector<std::pair<uint32_t, uint32_t>> edges{{2, 0}, {0, 3}, {2, 1}, {0, 1},
+                                                     {3, 3}, {0, 2}, {2, 0}};
+    linear_memory_resource                     memory(1000);
+    csr_graph_view<uint32_t> graph = create::csr_graph<uint32_t>(memory, 5, edges, 1);
+    EXPECT_EQ(graph.vertex_count(), 5);
+    EXPECT_EQ(graph.edge_count(), edges.size());
+    EXPECT_THAT(graph.offsets, testing::ElementsAre(0, 3, 3, 6, 7, 7));
+    EXPECT_THAT(graph.adjacent(0), testing::ElementsAre(1, 2, 3));
+    EXPECT_TRUE(graph.adjacent(1).empty());
+    EXPECT_THAT(graph.adjacent(2), testing::ElementsAre(0, 0, 1));
+    EXPECT_THAT(graph.adjacent(3), testing::ElementsAre(3));
+    EXPECT_TRUE(graph.adjacent(4).empty());
+
+    // Only the offsets and neighbors are allocated
+    EXPECT_EQ(memory.size(), (6 + edges.size()) * sizeof(uint32_t));
+}
+
+TEST(CsrGraph, ParallelDeterministic) {
+    std::vector<std::pair<uint64_t, uint64_t>> edges;
+    for (uint64_t i = 0; i < 20000; ++i)
+        edges.emplace_back((i * 7919) % 1000, (i * 104729) % 1000);
+    linear_memory_resource   serialMemory(1000000);
+    linear_memory_resource   parallelMemory(1000000);
+    csr_graph_view<uint64_t> serial = create::csr_graph<uint64_t>(serialMemory, 1000, edges, 1);
+    csr_graph_view<uint64_t> parallel =
+        create::csr_graph<uint64_t>(parallelMemory, 1000, edges, 8);
+    EXPECT_TRUE(std::ranges::equal(serial.offsets, parallel.offsets));
+    EXPECT_TRUE(std::ranges::equal(serial.neighbors, parallel.neighbors));
+}
+
+TEST(CsrGraph, InvalidEdges) {
+    linear_memory_resource memory(1000);
+    std::vector<std::pair<uint32_t, uint32_t>> badSource{{0, 1}, {5, 0}};
+    std::vector<std::pair<uint32_t, uint32_t>> badDestination{{0, 1}, {1, 5}};
+    EXPECT_THROW((void)create::csr_graph<uint32_t>(memory, 5, badSource, 1), std::out_of_range);
+    EXPECT_THROW((void)create::csr_graph<uint32_t>(memory, 5, badDestination, 4),
+                 std::out_of_range);
+
+    // 65536 edges do not fit in uint16_t offsets and vertex 300 is not a uint8_t
+    std::vector<std::pair<uint16_t, uint16_t>> manyEdges(65536, {0, 0});
+    EXPECT_THROW((void)create::csr_graph<uint16_t>(memory, 1, manyEdges, 1), std::length_error);
+    std::vector<std::pair<uint32_t, uint32_t>> oneEdge{{0, 0}};
+    EXPECT_THROW((void)create::csr_graph<uint8_t>(memory, 300, oneEdge, 1), std::length_error);
+
+    // Nothing was allocated
+    EXPECT_EQ(memory.size(), 0);
+}
+
+TEST(RadixTree, InsertFind) {
+    linear_memory_resource                       memory(1 << 20);
+    radix_tree_builder<linear_memory_resource<>> builder(memory);
+    std::vector<std::string> keys{"",       "a",       "ab",     "abc", "abd", "b",
+                                  "banana", "bandana", "band",   "x",   "xyzzy"};
+    // Long shared prefixes exceed the stored prefix bytes
+    for (int i = 0; i < 20; ++i)
+        keys.push_back("a_very_long_shared_prefix_" + std::to_string(i));
+    // Every byte value after a common prefix grows a node to node256
+    for (int i = 0; i < 256; ++i)
+        keys.push_back(std::string("fan") + static_cast<char>(i));
+    for (size_t i = 0; i < keys.size(); ++i)
+        EXPECT_TRUE(builder.insert(keys[i], i));
+    EXPECT_FALSE(builder.insert("banana", 1234));
+    radix_tree_view view = builder.view();
+    EXPECT_EQ(view.size(), keys.size());
+    for (size_t i = 0; i < keys.size(); ++i)
+        EXPECT_EQ(view.find(keys[i]), keys[i] == "banana" ? 1234 : i) << keys[i];
+    for (std::string_view missing : {"ba", "bananas", "abe", "fa", "y",
+                                     "a_very_long_shared_prefiX_1", "a_very_long_shared_prefix_"})
+        EXPECT_FALSE(view.contains(missing)) << missing;
+}
+
+TEST(RadixTree, Relocatable) {
+    linear_memory_resource                       memory(1 << 20);
+    radix_tree_builder<linear_memory_resource<>> builder(memory);
+    for (int i = 0; i < 1000; ++i)
+        builder.insert("key" + std::to_string(i * 37), static_cast<uint64_t>(i));
+
+    // Self-relative links remain valid at a different address, e.g. a mapping
+    auto*                 base = static_cast<std::byte*>(memory.data());
+    size_t                offset = reinterpret_cast<const std::byte*>(&builder.root()) - base;
+    std::vector<uint64_t> copy((memory.size() + 7) / 8);
+    std::memcpy(copy.data(), base, memory.size());
+    std::memset(base, 0xff, memory.size());
+    radix_tree_view view(*reinterpret_cast<const radix_tree_root*>(
+        reinterpret_cast<const std::byte*>(copy.data()) + offset));
+    EXPECT_EQ(view.size(), 1000);
+    for (int i = 0; i < 1000; ++i)
+        EXPECT_EQ(view.find("key" + std::to_string(i * 37)), static_cast<uint64_t>(i));
+    EXPECT_FALSE(view.contains("key1"));
+}
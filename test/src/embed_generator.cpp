@@ -0,0 +1,22 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#include "embedded_table.hpp"
+#include <decodeless/allocator.hpp>
+#include <decodeless/allocator_construction.hpp>
+#include <decodeless/embedded_arena.hpp>
+#include <iostream>
+
+// Writes a small arena image at build time for the embedded arena tests
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <image>\n";
+        return 1;
+    }
+    decodeless::linear_memory_resource memory(1024);
+    EmbeddedTable* table = decodeless::create::object<EmbeddedTable>(memory);
+    table->count = 15;
+    for (uint32_t i = 0; i < table->count; ++i)
+        table->squares[i] = i * i;
+    decodeless::write_arena_image(memory, argv[1]);
+    return 0;
+}
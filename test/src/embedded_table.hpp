@@ -0,0 +1,11 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+#pragma once
+
+#include <cstdint>
+
+// Root object of the test arena image embedded by decodeless_embed_arena()
+struct alignas(16) EmbeddedTable {
+    uint32_t count;
+    uint32_t squares[15];
+};
@@ -0,0 +1,24 @@
+// Copyright (c) 2024 Pyarelal Knowles, MIT License
+
+// Out of line instances of linear_memory_resource::allocate() for each parent
+// type. check_instruction_budget.cmake disassembles these to verify the inlined
+// fast path stays small, i.e. that the growth path remains out of line.
+
+#include <decodeless/allocator.hpp>
+#include <decodeless/virtual_memory_resource.hpp>
+
+using namespace decodeless;
+
+extern "C" void* fast_path_allocator(linear_memory_resource<>& resource, size_t bytes) {
+    return resource.allocate(bytes, 8);
+}
+
+extern "C" void* fast_path_virtual_memory(linear_memory_resource<virtual_memory_resource>& resource,
+                                          size_t                                          bytes) {
+    return resource.allocate(bytes, 8);
+}
+
+extern "C" void* fast_path_nested(linear_memory_resource<linear_memory_resource<>>& resource,
+                                  size_t                                           bytes) {
+    return resource.allocate(bytes, 8);
+}